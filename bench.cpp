@@ -0,0 +1,615 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "body.hpp"
+#include "chunked_tilemap.hpp"
+#include "fixed_physics.hpp"
+#include "job_system.hpp"
+#include "level.hpp"
+#include "physics.hpp"
+#include "raycast.hpp"
+#include "solid_map.hpp"
+#include "solid_probe.hpp"
+#include "spatial_hash.hpp"
+#include "tilemap.hpp"
+#include "world.hpp"
+
+namespace {
+
+/** Small deterministic generator, so that the positions and maps are
+    the same across platforms and standard libraries */
+class XorShift
+{
+private:
+  uint64_t m_state;
+
+public:
+  explicit XorShift(uint64_t seed) : m_state(seed) {}
+
+  uint32_t next()
+  {
+    m_state ^= m_state << 13;
+    m_state ^= m_state >> 7;
+    m_state ^= m_state << 17;
+    return static_cast<uint32_t>(m_state >> 32);
+  }
+
+  /** Returns a float in [lo, hi) */
+  float range(float lo, float hi)
+  {
+    return lo + (hi - lo) * (static_cast<float>(next() >> 8) / 16777216.0f);
+  }
+};
+
+/** Random map with roughly one solid tile out of \a solid_ratio */
+TileMap random_map(int width, int height, unsigned int solid_ratio, uint64_t seed)
+{
+  XorShift rng(seed);
+  TileMap map(width, height);
+  for(int y = 0; y < height; ++y)
+    for(int x = 0; x < width; ++x)
+      {
+        if (rng.next() % solid_ratio == 0)
+          map.set(x, y, '#');
+      }
+  return map;
+}
+
+struct Result
+{
+  std::string name;
+  std::string map;
+  uint64_t queries;
+  double seconds;
+  uint64_t checksum;
+};
+
+/** Makes \a value observable to the compiler without storing it */
+inline void keep_alive(uint64_t value)
+{
+#if defined(__GNUC__)
+  __asm__ __volatile__("" : : "g"(value) : "memory");
+#else
+  static volatile uint64_t sink;
+  sink = value;
+  (void)sink;
+#endif
+}
+
+/** Calls \a func on all \a items repeatedly until at least \a min_time
+    seconds have passed. The checksum is the sum of the results of a
+    single pass, so it can be compared across runs and commits. */
+template<typename Map, typename Item, typename Func>
+Result run_benchmark(const std::string& name, const Map& map,
+                     const std::vector<Item>& items, double min_time, Func func)
+{
+  Result result;
+  result.name = name;
+  result.map = std::to_string(map.get_width()) + "x" + std::to_string(map.get_height());
+  result.queries = 0;
+  result.checksum = 0;
+
+  uint64_t sum = 0;
+  bool first_pass = true;
+  auto start = std::chrono::steady_clock::now();
+  double seconds = 0.0;
+  do
+    {
+      for(const auto& item : items)
+        {
+          sum += func(item);
+        }
+      result.queries += items.size();
+
+      if (first_pass)
+        {
+          result.checksum = sum;
+          first_pass = false;
+        }
+
+      seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+  while(seconds < min_time);
+
+  // keep the compiler from dropping the repeated passes
+  keep_alive(sum);
+
+  result.seconds = seconds;
+  return result;
+}
+
+struct Point
+{
+  float x;
+  float y;
+};
+
+template<typename Map>
+std::vector<Point> random_points(const Map& map, size_t count, uint64_t seed)
+{
+  XorShift rng(seed);
+  const float w = static_cast<float>(map.get_width() * map.get_tile_size());
+  const float h = static_cast<float>(map.get_height() * map.get_tile_size());
+
+  std::vector<Point> points(count);
+  for(auto& point : points)
+    {
+      // include a small border outside of the map to cover the
+      // out-of-bounds path
+      point.x = rng.range(-32.0f, w + 32.0f);
+      point.y = rng.range(-32.0f, h + 32.0f);
+    }
+  return points;
+}
+
+template<typename Map>
+std::vector<Body> random_bodies(const Map& map, size_t count, uint64_t seed)
+{
+  XorShift rng(seed + 1);
+  std::vector<Body> bodies(count);
+  std::vector<Point> points = random_points(map, count, seed);
+  for(size_t i = 0; i < count; ++i)
+    {
+      bodies[i].x = points[i].x;
+      bodies[i].y = points[i].y;
+      bodies[i].vel_y = 0;
+      bodies[i].duck = (rng.next() & 1) != 0;
+    }
+  return bodies;
+}
+
+template<typename Map>
+std::vector<Ray> random_rays(const Map& map, size_t count, uint64_t seed)
+{
+  XorShift rng(seed + 1);
+  std::vector<Point> points = random_points(map, count, seed);
+  std::vector<Ray> rays(count);
+  for(size_t i = 0; i < count; ++i)
+    {
+      rays[i].x = points[i].x;
+      rays[i].y = points[i].y;
+      rays[i].dx = rng.range(-256.0f, 256.0f);
+      rays[i].dy = rng.range(-256.0f, 256.0f);
+      rays[i].max_t = 1.0f;
+    }
+  return rays;
+}
+
+typedef void (*ProbeFunc)(const SolidMap&, const float*, const float*, size_t, uint8_t*);
+struct ProbeImpl { const char* name; ProbeFunc func; };
+
+/** Exits with an error unless every probe implementation gives the same
+    result as SolidMap::is_solid() for \a xs, \a ys and for points far
+    outside of the map, an odd count covers the scalar tails */
+void check_probes(const SolidMap& solid, const std::vector<ProbeImpl>& impls,
+                  std::vector<float> xs, std::vector<float> ys)
+{
+  XorShift rng(9);
+  const float w = static_cast<float>(solid.get_width_px());
+  const float h = static_cast<float>(solid.get_height_px());
+  for(int i = 0; i < 4099; ++i)
+    {
+      xs.push_back(rng.range(-2.0f * w, 3.0f * w));
+      ys.push_back(rng.range(-2.0f * h, 3.0f * h));
+    }
+  const float edges[] = { -1.0e9f, -1.0f, -0.5f, 0.0f, 0.5f, w - 0.5f, w, w + 0.5f, 1.0e9f };
+  for(float x : edges)
+    for(float y : edges)
+      {
+        xs.push_back(x);
+        ys.push_back(y);
+      }
+
+  std::vector<uint8_t> out(xs.size());
+  for(const auto& impl : impls)
+    {
+      std::fill(out.begin(), out.end(), 2);
+      impl.func(solid, xs.data(), ys.data(), xs.size(), out.data());
+      for(size_t i = 0; i < xs.size(); ++i)
+        {
+          if (out[i] != (solid.is_solid(xs[i], ys[i]) ? 1 : 0))
+            {
+              std::cerr << "error: " << impl.name << " differs from SolidMap::is_solid() at ("
+                        << xs[i] << ", " << ys[i] << ")" << std::endl;
+              exit(EXIT_FAILURE);
+            }
+        }
+    }
+}
+
+/** Runs the batched probe implementations over \a points, 256 points
+    per call, queries are counted per point */
+void bench_probes(std::vector<Result>& results, const SolidMap& solid,
+                  const std::vector<Point>& points, double min_time)
+{
+  std::vector<float> xs;
+  std::vector<float> ys;
+  for(const auto& p : points)
+    {
+      xs.push_back(p.x);
+      ys.push_back(p.y);
+    }
+
+  std::vector<ProbeImpl> impls = {
+    { "probe_scalar", solid_probe_batch_scalar },
+    { "probe_sse2", solid_probe_batch_sse2 },
+    { "probe_dispatch", solid_probe_batch }
+  };
+  if (solid_probe_has_avx2())
+    impls.push_back({ "probe_avx2", solid_probe_batch_avx2 });
+
+  check_probes(solid, impls, xs, ys);
+
+  const size_t batch_size = 256;
+  std::vector<size_t> batches;
+  for(size_t i = 0; i + batch_size <= points.size(); i += batch_size)
+    batches.push_back(i);
+  std::vector<uint8_t> out(batch_size);
+
+  for(const auto& impl : impls)
+    {
+      Result result = run_benchmark(impl.name, solid, batches, min_time,
+                                    [&](size_t start) -> uint64_t {
+                                      impl.func(solid, xs.data() + start, ys.data() + start, batch_size, out.data());
+                                      uint64_t sum = 0;
+                                      for(uint8_t v : out)
+                                        sum += v;
+                                      return sum;
+                                    });
+      result.queries *= batch_size;
+      results.push_back(result);
+    }
+}
+
+void bench_map(std::vector<Result>& results, const TileMap& map, double min_time)
+{
+  const size_t count = 1 << 16;
+
+  std::vector<Point> points = random_points(map, count, 1);
+  results.push_back(run_benchmark("get_tile", map, points, min_time,
+                                  [&map](const Point& p) -> uint64_t {
+                                    return map.get_tile(p.x, p.y) != ' ';
+                                  }));
+
+  results.push_back(run_benchmark("get_tile_px", map, points, min_time,
+                                  [&map](const Point& p) -> uint64_t {
+                                    return map.get_tile_px(static_cast<int>(p.x), static_cast<int>(p.y)) != ' ';
+                                  }));
+
+  std::vector<Body> bodies = random_bodies(map, count, 2);
+  results.push_back(run_benchmark("body_overlaps", map, bodies, min_time,
+                                  [&map](const Body& body) -> uint64_t {
+                                    return body_overlaps(map, body);
+                                  }));
+
+  results.push_back(run_benchmark("body_on_ground", map, bodies, min_time,
+                                  [&map](const Body& body) -> uint64_t {
+                                    return body_on_ground(map, body);
+                                  }));
+
+  const SolidMap solid(map);
+  results.push_back(run_benchmark("solid_is_solid", solid, points, min_time,
+                                  [&solid](const Point& p) -> uint64_t {
+                                    return solid.is_solid(p.x, p.y);
+                                  }));
+
+  results.push_back(run_benchmark("solid_body_overlaps", solid, bodies, min_time,
+                                  [&solid](const Body& body) -> uint64_t {
+                                    return body_overlaps(solid, body);
+                                  }));
+
+  results.push_back(run_benchmark("solid_body_on_ground", solid, bodies, min_time,
+                                  [&solid](const Body& body) -> uint64_t {
+                                    return body_on_ground(solid, body);
+                                  }));
+
+  bench_probes(results, solid, points, min_time);
+
+  std::vector<Ray> rays = random_rays(map, count, 5);
+  results.push_back(run_benchmark("raycast", solid, rays, min_time,
+                                  [&solid](const Ray& ray) -> uint64_t {
+                                    RayHit hit;
+                                    return raycast(solid, ray, hit) ? hit.tile_x + hit.tile_y : 0;
+                                  }));
+
+  // the batch variant gets one item per 256 rays, queries are still
+  // counted per ray
+  const size_t batch_size = 256;
+  std::vector<size_t> batches;
+  for(size_t i = 0; i < rays.size(); i += batch_size)
+    batches.push_back(i);
+  std::vector<RayHit> hits(batch_size);
+  Result batch = run_benchmark("raycast_batch", solid, batches, min_time,
+                               [&](size_t start) -> uint64_t {
+                                 return raycast_batch(solid, rays.data() + start, batch_size, hits.data());
+                               });
+  batch.queries *= batch_size;
+  results.push_back(batch);
+}
+
+/** Runs the same queries as bench_map() through a ChunkedTileMap that
+    can only keep a quarter of \a map resident */
+void bench_chunked(std::vector<Result>& results, const TileMap& map, double min_time)
+{
+  const size_t count = 1 << 16;
+  const size_t map_bytes = static_cast<size_t>(map.get_width()) * static_cast<size_t>(map.get_height());
+
+  ChunkedTileMap chunked(std::unique_ptr<ChunkLoader>(new MemoryChunkLoader(map)), map_bytes / 4);
+
+  std::vector<Point> points = random_points(chunked, count, 1);
+  results.push_back(run_benchmark("chunked_get_tile", chunked, points, min_time,
+                                  [&chunked](const Point& p) -> uint64_t {
+                                    return chunked.get_tile(p.x, p.y) != ' ';
+                                  }));
+
+  std::vector<Body> bodies = random_bodies(chunked, count, 2);
+  results.push_back(run_benchmark("chunked_body_overlaps", chunked, bodies, min_time,
+                                  [&chunked](const Body& body) -> uint64_t {
+                                    return body_overlaps(chunked, body);
+                                  }));
+
+  // the same queries with the per tick prefetch headless does
+  results.push_back(run_benchmark("chunked_prefetch_body_overlaps", chunked, bodies, min_time,
+                                  [&chunked](const Body& body) -> uint64_t {
+                                    chunked.prefetch(body.x, body.y, BODY_PREFETCH_RADIUS);
+                                    return body_overlaps(chunked, body);
+                                  }));
+}
+
+/** Fills a World with \a count bodies at random positions, walking in
+    random directions */
+World random_world(const SolidMap& map, size_t count, uint64_t seed)
+{
+  XorShift rng(seed + 1);
+  std::vector<Body> bodies = random_bodies(map, count, seed);
+  World world;
+  world.reserve(count);
+  for(auto& body : bodies)
+    {
+      body.direction = (rng.next() & 1) ? Body::LEFT : Body::RIGHT;
+      world.add_body(body);
+    }
+  return world;
+}
+
+/** Exits with an error unless SpatialHash::find_overlaps() reports
+    exactly the pairs a brute force test of all body boxes in \a world
+    finds */
+void check_broadphase(const World& world)
+{
+  const size_t count = world.size();
+  std::vector<Aabb> boxes(count);
+  for(size_t i = 0; i < count; ++i)
+    boxes[i] = body_aabb(world.get_x()[i], world.get_y()[i], (world.get_flags()[i] & World::FLAG_DUCK) != 0);
+
+  std::vector<uint64_t> expected;
+  for(size_t a = 0; a < count; ++a)
+    for(size_t b = a + 1; b < count; ++b)
+      if (aabb_overlap(boxes[a], boxes[b]))
+        expected.push_back((static_cast<uint64_t>(a) << 32) | b);
+
+  SpatialHash hash;
+  std::vector<BodyPair> pairs;
+  hash.rebuild(world);
+  hash.find_overlaps(pairs);
+  std::vector<uint64_t> found;
+  for(const auto& pair : pairs)
+    found.push_back((static_cast<uint64_t>(pair.a) << 32) | pair.b);
+  std::sort(found.begin(), found.end());
+
+  if (found != expected)
+    {
+      std::cerr << "error: SpatialHash::find_overlaps() found " << found.size()
+                << " pairs, brute force found " << expected.size() << std::endl;
+      exit(EXIT_FAILURE);
+    }
+}
+
+/** Steps a whole World per item, queries are counted per body step */
+void bench_world(std::vector<Result>& results, const TileMap& map, size_t count, double min_time)
+{
+  const SolidMap solid(map);
+  World world = random_world(solid, count, 6);
+
+  std::vector<int> steps(1);
+  Result result = run_benchmark("world_step_" + std::to_string(count), solid, steps, min_time,
+                                [&](int) -> uint64_t {
+                                  world.step(solid, BODY_REFERENCE_STEP);
+                                  return static_cast<uint64_t>(world.get_x()[0]) + static_cast<uint64_t>(world.get_y()[0]);
+                                });
+  result.queries *= count;
+  results.push_back(result);
+}
+
+/** Steps the same World with 1, 2, 4, ... up to \a max_threads
+    threads, the checksum is the same for every thread count */
+void bench_world_scaling(std::vector<Result>& results, const TileMap& map, size_t count,
+                         unsigned int max_threads, double min_time)
+{
+  const SolidMap solid(map);
+
+  std::vector<unsigned int> thread_counts;
+  for(unsigned int threads = 1; threads < max_threads; threads *= 2)
+    thread_counts.push_back(threads);
+  thread_counts.push_back(max_threads);
+
+  for(unsigned int threads : thread_counts)
+    {
+      JobSystem jobs(threads);
+      World world = random_world(solid, count, 6);
+
+      std::vector<int> steps(1);
+      Result result = run_benchmark("world_step_" + std::to_string(count) + "_threads_" + std::to_string(threads),
+                                    solid, steps, min_time,
+                                    [&](int) -> uint64_t {
+                                      world.step(solid, BODY_REFERENCE_STEP, jobs);
+                                      return static_cast<uint64_t>(world.get_x()[count - 1]) +
+                                        static_cast<uint64_t>(world.get_y()[count - 1]);
+                                    });
+      result.queries *= count;
+      results.push_back(result);
+    }
+}
+
+/** Steps the same bodies with the float and the fixed-point physics,
+    queries are counted per body step, each pass continues from the
+    state of the previous one */
+void bench_step(std::vector<Result>& results, const TileMap& map, double min_time)
+{
+  const size_t count = 1 << 12;
+  const SolidMap solid(map);
+  World world = random_world(solid, count, 8);
+
+  std::vector<Body> bodies(count);
+  std::vector<FixedBody> fixed_bodies(count);
+  for(size_t i = 0; i < count; ++i)
+    {
+      bodies[i] = world.get_body(i);
+      fixed_bodies[i].x = Fixed::from_float(bodies[i].x);
+      fixed_bodies[i].y = Fixed::from_float(bodies[i].y);
+      fixed_bodies[i].duck = bodies[i].duck;
+      fixed_bodies[i].direction = bodies[i].direction;
+    }
+
+  std::vector<size_t> indices(count);
+  for(size_t i = 0; i < count; ++i)
+    indices[i] = i;
+
+  results.push_back(run_benchmark("step_float", solid, indices, min_time,
+                                  [&](size_t i) -> uint64_t {
+                                    Body& body = bodies[i];
+                                    body_step_swept(solid, body, BODY_REFERENCE_STEP);
+                                    return static_cast<uint64_t>(static_cast<int>(body.x)) + static_cast<uint64_t>(static_cast<int>(body.y));
+                                  }));
+
+  results.push_back(run_benchmark("step_fixed", solid, indices, min_time,
+                                  [&](size_t i) -> uint64_t {
+                                    FixedBody& body = fixed_bodies[i];
+                                    fixed_body_step(solid, body, FIXED_REFERENCE_STEP);
+                                    return static_cast<uint64_t>(body.x.floor_int()) +
+                                      static_cast<uint64_t>(body.y.floor_int());
+                                  }));
+}
+
+/** Rebuilds the spatial hash for a World and collects the overlapping
+    pairs, queries are counted per body */
+void bench_broadphase(std::vector<Result>& results, const TileMap& map, size_t count, double min_time)
+{
+  const SolidMap solid(map);
+  const World world = random_world(solid, count, 7);
+  SpatialHash hash;
+  std::vector<BodyPair> pairs;
+
+  std::vector<int> steps(1);
+  Result result = run_benchmark("broadphase_" + std::to_string(count), solid, steps, min_time,
+                                [&](int) -> uint64_t {
+                                  pairs.clear();
+                                  hash.rebuild(world);
+                                  hash.find_overlaps(pairs);
+                                  return pairs.size();
+                                });
+  result.queries *= count;
+  results.push_back(result);
+}
+
+std::string json_escape(const std::string& text)
+{
+  std::string out;
+  for(char c : text)
+    {
+      if (c == '"' || c == '\\')
+        out += '\\';
+      out += c;
+    }
+  return out;
+}
+
+void print_json(std::ostream& out, const std::vector<Result>& results)
+{
+  out << "{\n  \"benchmarks\": [\n";
+  for(size_t i = 0; i < results.size(); ++i)
+    {
+      const Result& r = results[i];
+      out << "    { \"name\": \"" << json_escape(r.name) << "\""
+          << ", \"map\": \"" << json_escape(r.map) << "\""
+          << ", \"queries\": " << r.queries
+          << ", \"seconds\": " << r.seconds
+          << ", \"queries_per_second\": " << static_cast<uint64_t>(r.seconds > 0.0 ? r.queries / r.seconds : 0.0)
+          << ", \"checksum\": " << r.checksum
+          << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+  out << "  ]\n}" << std::endl;
+}
+
+void print_usage(const char* program)
+{
+  std::cout << "Usage: " << program << " [OPTION]...\n"
+            << "Measures collision query throughput and prints the results as JSON.\n\n"
+            << "  -t, --min-time SEC  Minimum run time per benchmark (default: 0.25)\n"
+            << "  -j, --max-threads N Highest thread count for the scaling benchmark\n"
+            << "                      (default: one per hardware thread)\n"
+            << "  -h, --help          Display this help and exit\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  double min_time = 0.25;
+  unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  for(int i = 1; i < argc; ++i)
+    {
+      const char* arg = argv[i];
+      if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0)
+        {
+          print_usage(argv[0]);
+          return EXIT_SUCCESS;
+        }
+      else if (i + 1 < argc && (strcmp(arg, "-t") == 0 || strcmp(arg, "--min-time") == 0))
+        {
+          min_time = std::atof(argv[++i]);
+        }
+      else if (i + 1 < argc && (strcmp(arg, "-j") == 0 || strcmp(arg, "--max-threads") == 0))
+        {
+          max_threads = static_cast<unsigned int>(std::max(1, std::atoi(argv[++i])));
+        }
+      else
+        {
+          std::cerr << argv[0] << ": invalid argument '" << arg << "'" << std::endl;
+          print_usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+    }
+
+  std::vector<Result> results;
+
+  bench_map(results, default_level(), min_time);
+
+  const TileMap small = random_map(256, 256, 4, 3);
+  bench_map(results, small, min_time);
+  // a crowded world keeps the quadratic check short while still
+  // producing plenty of overlapping pairs
+  check_broadphase(random_world(SolidMap(small), 8192, 8));
+  const TileMap large = random_map(4096, 1024, 4, 4);
+  bench_map(results, large, min_time);
+  bench_chunked(results, large, min_time);
+  bench_step(results, large, min_time);
+  bench_world(results, large, 4096, min_time);
+  bench_world_scaling(results, large, 65536, max_threads, min_time);
+  bench_broadphase(results, large, 4096, min_time);
+  bench_broadphase(results, large, 65536, min_time);
+
+  print_json(std::cout, results);
+
+  return EXIT_SUCCESS;
+}
+
+/* EOF */
@@ -0,0 +1,99 @@
+#include <SDL.h>
+#include <SDL_image.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "packed_font.hpp"
+
+/* Converts a glyph sheet to the packed font format read by jumpnrun,
+   see src/packed_font.hpp. Run by the build, so the embedded font is
+   always in sync with the image. Transparency is taken from the alpha
+   channel of the image. */
+
+namespace {
+
+/** Returns a copy of \a image with r, g, b, a in byte order */
+SDL_Surface* to_rgba(SDL_Surface* image)
+{
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+  const Uint32 rmask = 0xff000000, gmask = 0x00ff0000, bmask = 0x0000ff00, amask = 0x000000ff;
+#else
+  const Uint32 rmask = 0x000000ff, gmask = 0x0000ff00, bmask = 0x00ff0000, amask = 0xff000000;
+#endif
+
+  SDL_Surface* rgba = SDL_CreateRGBSurface(SDL_SWSURFACE, image->w, image->h, 32, rmask, gmask, bmask, amask);
+  if (!rgba)
+    return 0;
+
+  // copy the alpha channel instead of blending with it
+  SDL_SetAlpha(image, 0, SDL_ALPHA_OPAQUE);
+  SDL_BlitSurface(image, NULL, rgba, NULL);
+  return rgba;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc != 5)
+    {
+      fprintf(stderr, "Usage: %s IMAGE OUTPUT GLYPH_WIDTH GLYPH_HEIGHT\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  const char* image_file = argv[1];
+  const char* output_file = argv[2];
+  const int glyph_width = atoi(argv[3]);
+  const int glyph_height = atoi(argv[4]);
+
+  SDL_Surface* image = IMG_Load(image_file);
+  if (!image)
+    {
+      fprintf(stderr, "%s: %s\n", image_file, IMG_GetError());
+      return EXIT_FAILURE;
+    }
+
+  if (glyph_width <= 0 || glyph_height <= 0 ||
+      image->w % glyph_width != 0 || image->h % glyph_height != 0)
+    {
+      fprintf(stderr, "%s: %dx%d is not a multiple of the glyph size %dx%d\n",
+              image_file, image->w, image->h, glyph_width, glyph_height);
+      return EXIT_FAILURE;
+    }
+
+  SDL_Surface* rgba = to_rgba(image);
+  if (!rgba)
+    {
+      fprintf(stderr, "%s: %s\n", image_file, SDL_GetError());
+      return EXIT_FAILURE;
+    }
+
+  SDL_LockSurface(rgba);
+  const std::vector<uint8_t> data = pack_font(static_cast<const uint8_t*>(rgba->pixels), rgba->w, rgba->h,
+                                              rgba->pitch, glyph_width, glyph_height);
+  SDL_UnlockSurface(rgba);
+
+  SDL_FreeSurface(rgba);
+  SDL_FreeSurface(image);
+
+  // the whole sheet is written at once
+  FILE* out = fopen(output_file, "wb");
+  if (!out)
+    {
+      perror(output_file);
+      return EXIT_FAILURE;
+    }
+
+  const bool written = fwrite(data.data(), 1, data.size(), out) == data.size();
+  if (fclose(out) != 0 || !written)
+    {
+      perror(output_file);
+      remove(output_file);
+      return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+/* EOF */
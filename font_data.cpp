@@ -0,0 +1,27 @@
+#include "font_data.hpp"
+
+// JNRCOL_FONT_FILE is the absolute path of the packed font, set by
+// CMake. The data goes into .rodata with .incbin, so it costs neither
+// a huge generated header nor any work at startup.
+__asm__(
+  "  .section .rodata\n"
+  "  .balign 16\n"
+  "jnrcol_font_data:\n"
+  "  .incbin \"" JNRCOL_FONT_FILE "\"\n"
+  "jnrcol_font_data_end:\n"
+  "  .previous\n");
+
+extern "C" const unsigned char jnrcol_font_data[];
+extern "C" const unsigned char jnrcol_font_data_end[];
+
+const unsigned char* get_font_data()
+{
+  return jnrcol_font_data;
+}
+
+size_t get_font_data_size()
+{
+  return static_cast<size_t>(jnrcol_font_data_end - jnrcol_font_data);
+}
+
+/* EOF */
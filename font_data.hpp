@@ -0,0 +1,13 @@
+#ifndef HEADER_JNRCOL_FONT_DATA_HPP
+#define HEADER_JNRCOL_FONT_DATA_HPP
+
+#include <cstddef>
+
+/** The packed glyph sheet (see src/packed_font.hpp) linked into the
+    executable */
+const unsigned char* get_font_data();
+size_t get_font_data_size();
+
+#endif
+
+/* EOF */
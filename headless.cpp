@@ -0,0 +1,517 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "body.hpp"
+#include "chunked_tilemap.hpp"
+#include "fixed_physics.hpp"
+#include "input_log.hpp"
+#include "job_system.hpp"
+#include "level.hpp"
+#include "level_file.hpp"
+#include "physics.hpp"
+#include "solid_map.hpp"
+#include "spatial_hash.hpp"
+#include "world.hpp"
+
+namespace {
+
+/** One segment of scripted input, i.e. a set of held keys and the
+    number of ticks they are held for */
+struct ScriptSegment
+{
+  bool left;
+  bool right;
+  bool jump;
+  bool duck;
+  long ticks;
+};
+
+/** Parses a script of the form "R200,RJ20,L200,-50", each segment
+    being a combination of the keys L, R, J, D (or '-' for no key)
+    followed by the number of ticks they are held */
+std::vector<ScriptSegment> parse_script(const std::string& text)
+{
+  std::vector<ScriptSegment> script;
+
+  std::istringstream in(text);
+  std::string item;
+  while(std::getline(in, item, ','))
+    {
+      ScriptSegment segment = { false, false, false, false, 0 };
+
+      std::string::size_type i = 0;
+      for(; i < item.size() && !isdigit(static_cast<unsigned char>(item[i])); ++i)
+        {
+          switch(item[i])
+            {
+              case 'L': segment.left  = true; break;
+              case 'R': segment.right = true; break;
+              case 'J': segment.jump  = true; break;
+              case 'D': segment.duck  = true; break;
+              case '-': break;
+              default:
+                throw std::runtime_error("unknown key '" + std::string(1, item[i]) + "' in script");
+            }
+        }
+
+      if (i == item.size())
+        throw std::runtime_error("missing tick count in script segment '" + item + "'");
+
+      segment.ticks = std::atol(item.c_str() + i);
+      if (segment.ticks <= 0)
+        throw std::runtime_error("invalid tick count in script segment '" + item + "'");
+
+      script.push_back(segment);
+    }
+
+  if (script.empty())
+    throw std::runtime_error("empty script");
+
+  return script;
+}
+
+uint8_t to_input(const ScriptSegment& segment)
+{
+  return static_cast<uint8_t>((segment.left  ? INPUT_LEFT  : 0) |
+                              (segment.right ? INPUT_RIGHT : 0) |
+                              (segment.jump  ? INPUT_JUMP  : 0) |
+                              (segment.duck  ? INPUT_DUCK  : 0));
+}
+
+/** Feeds input to the player the same way JumpnRun::run() does */
+template<typename Map>
+void apply_input(const Map& map, Body& player, const ScriptSegment& segment)
+{
+  apply_input(map, player, to_input(segment));
+}
+
+void apply_input(const SolidMap& map, FixedBody& player, const ScriptSegment& segment)
+{
+  apply_input_flags(player, to_input(segment), fixed_body_on_ground(map, player));
+}
+
+/** Loads the map around the player ahead of the collision queries,
+    only a ChunkedTileMap has anything to load */
+template<typename Map>
+void prefetch(const Map&, const Body&)
+{
+}
+
+void prefetch(const ChunkedTileMap& map, const Body& player)
+{
+  map.prefetch(player.x, player.y, BODY_PREFETCH_RADIUS);
+}
+
+/** A command line option and whether it was given */
+struct Option
+{
+  const char* name;
+  bool given;
+};
+
+/** Throws if \a option was given together with any of \a others,
+    which the run mode it selects would silently ignore */
+void check_conflicts(const Option& option, std::initializer_list<Option> others)
+{
+  if (!option.given)
+    return;
+
+  for(const Option& other : others)
+    if (other.given)
+      throw std::runtime_error(std::string(option.name) + " can't be combined with " + other.name);
+}
+
+void print_usage(const char* program)
+{
+  std::cout << "Usage: " << program << " [OPTION]...\n"
+            << "Runs the jumpnrun physics without video or TTY output.\n\n"
+            << "  -n, --ticks N       Number of physics ticks to simulate (default: 1000000)\n"
+            << "  -d, --delta SEC     Timestep per tick (default: 0.01)\n"
+            << "  -s, --script STR    Input script, looped until all ticks are done\n"
+            << "                      (default: \"R200,RJ20,L200,-50\")\n"
+            << "  -b, --bodies N      Step N bodies in a World (always swept)\n"
+            << "  -j, --threads N     Worker threads for --bodies, 0 for one per core\n"
+            << "                      (default: 1)\n"
+            << "  --swept             Use swept collision, allows larger timesteps\n"
+            << "  --fixed             Use the deterministic fixed-point physics (always\n"
+            << "                      swept), prints the raw final state\n"
+            << "  -l, --level FILE    Load the level from FILE instead of the builtin one\n"
+            << "  --stream BYTES      Stream the level from FILE in chunks, keeping at\n"
+            << "                      most BYTES of tile data resident\n"
+            << "  --save-level FILE   Write the level to FILE and exit\n"
+            << "  --record FILE       Write the input of every tick to FILE\n"
+            << "  --replay FILE       Replay an input log recorded by jumpnrun or\n"
+            << "                      --record instead of running the script\n"
+            << "  -h, --help          Display this help and exit\n";
+}
+
+template<typename Map>
+void print_result(const Map& map, const Body& player, long ticks, double seconds)
+{
+  std::cout << "ticks:      " << ticks << "\n"
+            << "position:   " << player.x << " " << player.y << "\n"
+            << "velocity:   " << player.vel_x << " " << player.vel_y << "\n"
+            << "on_ground:  " << body_on_ground(map, player) << "\n"
+            << "seconds:    " << seconds << "\n"
+            << "ticks/sec:  " << (seconds > 0.0 ? ticks / seconds : 0.0) << std::endl;
+}
+
+/** Runs the script, the input of each tick is appended to \a log
+    unless it is null */
+template<typename Map>
+void simulate(const Map& map, const std::vector<ScriptSegment>& script, long ticks, float delta, bool swept,
+              InputLog* log)
+{
+  Body player;
+
+  auto start = std::chrono::steady_clock::now();
+
+  long tick = 0;
+  std::vector<ScriptSegment>::size_type current = 0;
+  while(tick < ticks)
+    {
+      const ScriptSegment& segment = script[current];
+      for(long i = 0; i < segment.ticks && tick < ticks; ++i, ++tick)
+        {
+          prefetch(map, player);
+          apply_input(map, player, segment);
+          if (log)
+            log->record(to_input(segment));
+          if (swept)
+            body_step_swept(map, player, delta);
+          else
+            body_step(map, player, delta);
+        }
+      current = (current + 1) % script.size();
+    }
+
+  auto end = std::chrono::steady_clock::now();
+  print_result(map, player, tick, std::chrono::duration<double>(end - start).count());
+}
+
+/** Steps the player through \a log as fast as possible, with the same
+    input handling, timestep and physics step as the recorded run */
+void replay(const SolidMap& map, const InputLog& log)
+{
+  const float delta = log.get_delta();
+  const bool swept = log.get_step_mode() == InputLog::STEP_SWEPT;
+  Body player;
+
+  auto start = std::chrono::steady_clock::now();
+
+  for(size_t tick = 0; tick < log.size(); ++tick)
+    {
+      apply_input(map, player, log.get(tick));
+      if (swept)
+        body_step_swept(map, player, delta);
+      else
+        body_step(map, player, delta);
+    }
+
+  auto end = std::chrono::steady_clock::now();
+  print_result(map, player, static_cast<long>(log.size()), std::chrono::duration<double>(end - start).count());
+}
+
+/** Runs the script through the fixed-point physics, the raw state
+    printed at the end is bit-identical on every machine, the delta is
+    converted once so a float input can't cause drift */
+void simulate_fixed(const SolidMap& map, const std::vector<ScriptSegment>& script, long ticks, float delta)
+{
+  const Fixed fixed_delta = (delta == BODY_REFERENCE_STEP) ? FIXED_REFERENCE_STEP : Fixed::from_float(delta);
+  FixedBody player;
+
+  auto start = std::chrono::steady_clock::now();
+
+  long tick = 0;
+  std::vector<ScriptSegment>::size_type current = 0;
+  while(tick < ticks)
+    {
+      const ScriptSegment& segment = script[current];
+      for(long i = 0; i < segment.ticks && tick < ticks; ++i, ++tick)
+        {
+          apply_input(map, player, segment);
+          fixed_body_step(map, player, fixed_delta);
+        }
+      current = (current + 1) % script.size();
+    }
+
+  auto end = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(end - start).count();
+
+  std::cout << "ticks:      " << tick << "\n"
+            << "position:   " << player.x.to_float() << " " << player.y.to_float() << "\n"
+            << "velocity:   " << player.vel_x.to_float() << " " << player.vel_y.to_float() << "\n"
+            << "raw state:  " << std::hex << player.x.raw() << " " << player.y.raw() << " "
+            << player.vel_x.raw() << " " << player.vel_y.raw() << std::dec << "\n"
+            << "on_ground:  " << fixed_body_on_ground(map, player) << "\n"
+            << "seconds:    " << seconds << "\n"
+            << "ticks/sec:  " << (seconds > 0.0 ? tick / seconds : 0.0) << std::endl;
+}
+
+/** Steps \a num_bodies bodies spread over the map, all following the
+    same script */
+void simulate_world(const SolidMap& map, const std::vector<ScriptSegment>& script,
+                    long ticks, float delta, size_t num_bodies, unsigned int num_threads)
+{
+  JobSystem jobs(num_threads);
+
+  World world;
+  world.reserve(num_bodies);
+
+  const int spacing = 48;
+  const int columns = std::max(1, (map.get_width() * map.get_tile_size() - spacing) / spacing);
+  for(size_t i = 0; i < num_bodies; ++i)
+    {
+      Body body;
+      body.x = static_cast<float>(spacing + static_cast<int>(i % columns) * spacing);
+      body.y = static_cast<float>(100 + static_cast<int>(i / columns % 4) * 96);
+      world.add_body(body);
+    }
+
+  auto start = std::chrono::steady_clock::now();
+
+  long tick = 0;
+  std::vector<ScriptSegment>::size_type current = 0;
+  while(tick < ticks)
+    {
+      const ScriptSegment& segment = script[current];
+      for(long i = 0; i < segment.ticks && tick < ticks; ++i, ++tick)
+        {
+          for(size_t j = 0; j < world.size(); ++j)
+            {
+              Body body = world.get_body(j);
+              apply_input(map, body, segment);
+              world.set_flags(j, World::to_flags(body));
+            }
+          world.step(map, delta, jobs);
+        }
+      current = (current + 1) % script.size();
+    }
+
+  auto end = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(end - start).count();
+  double body_steps = static_cast<double>(tick) * static_cast<double>(num_bodies);
+
+  SpatialHash hash;
+  hash.rebuild(world);
+  std::vector<BodyPair> pairs;
+  hash.find_overlaps(pairs);
+
+  // FNV-1a over the final state, to compare runs with different thread counts
+  uint64_t checksum = 14695981039346656037ull;
+  for(size_t i = 0; i < world.size(); ++i)
+    {
+      const float values[] = { world.get_x()[i], world.get_y()[i], world.get_vel_x()[i], world.get_vel_y()[i] };
+      const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+      for(size_t j = 0; j < sizeof(values); ++j)
+        checksum = (checksum ^ bytes[j]) * 1099511628211ull;
+    }
+
+  std::cout << "ticks:      " << tick << "\n"
+            << "bodies:     " << num_bodies << "\n"
+            << "threads:    " << jobs.get_num_threads() << "\n"
+            << "body 0:     " << world.get_x()[0] << " " << world.get_y()[0] << "\n"
+            << "overlaps:   " << pairs.size() << " body pairs\n"
+            << "checksum:   " << std::hex << checksum << std::dec << "\n"
+            << "seconds:    " << seconds << "\n"
+            << "steps/sec:  " << (seconds > 0.0 ? body_steps / seconds : 0.0) << std::endl;
+}
+
+void print_stats(const ChunkedTileMap& map)
+{
+  const ChunkedTileMap::Stats& stats = map.get_stats();
+  std::cout << "chunks:     " << map.get_resident_chunks() << "/" << map.get_max_chunks() << " resident\n"
+            << "hits:       " << stats.hits << "\n"
+            << "misses:     " << stats.misses << "\n"
+            << "evictions:  " << stats.evictions << "\n"
+            << "load time:  " << stats.load_ns_total / 1000 << " us total, "
+            << stats.load_ns_max / 1000 << " us max" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  long ticks = 1000000;
+  float delta = 0.01f;
+  std::string script_text = "R200,RJ20,L200,-50";
+  std::string level_file;
+  std::string save_file;
+  std::string record_file;
+  std::string replay_file;
+  size_t stream_bytes = 0;
+  bool swept = false;
+  bool fixed = false;
+  size_t num_bodies = 0;
+  unsigned int num_threads = 1;
+  bool ticks_given = false;
+  bool delta_given = false;
+  bool script_given = false;
+  bool threads_given = false;
+
+  for(int i = 1; i < argc; ++i)
+    {
+      const char* arg = argv[i];
+      if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0)
+        {
+          print_usage(argv[0]);
+          return EXIT_SUCCESS;
+        }
+      else if (i + 1 < argc && (strcmp(arg, "-n") == 0 || strcmp(arg, "--ticks") == 0))
+        {
+          ticks = std::atol(argv[++i]);
+          ticks_given = true;
+        }
+      else if (i + 1 < argc && (strcmp(arg, "-d") == 0 || strcmp(arg, "--delta") == 0))
+        {
+          delta = static_cast<float>(std::atof(argv[++i]));
+          delta_given = true;
+        }
+      else if (i + 1 < argc && (strcmp(arg, "-s") == 0 || strcmp(arg, "--script") == 0))
+        {
+          script_text = argv[++i];
+          script_given = true;
+        }
+      else if (i + 1 < argc && (strcmp(arg, "-b") == 0 || strcmp(arg, "--bodies") == 0))
+        {
+          num_bodies = static_cast<size_t>(std::atol(argv[++i]));
+        }
+      else if (i + 1 < argc && (strcmp(arg, "-j") == 0 || strcmp(arg, "--threads") == 0))
+        {
+          num_threads = static_cast<unsigned int>(std::atoi(argv[++i]));
+          threads_given = true;
+        }
+      else if (strcmp(arg, "--swept") == 0)
+        {
+          swept = true;
+        }
+      else if (strcmp(arg, "--fixed") == 0)
+        {
+          fixed = true;
+        }
+      else if (i + 1 < argc && (strcmp(arg, "-l") == 0 || strcmp(arg, "--level") == 0))
+        {
+          level_file = argv[++i];
+        }
+      else if (i + 1 < argc && strcmp(arg, "--stream") == 0)
+        {
+          stream_bytes = static_cast<size_t>(std::atoll(argv[++i]));
+        }
+      else if (i + 1 < argc && strcmp(arg, "--save-level") == 0)
+        {
+          save_file = argv[++i];
+        }
+      else if (i + 1 < argc && strcmp(arg, "--record") == 0)
+        {
+          record_file = argv[++i];
+        }
+      else if (i + 1 < argc && strcmp(arg, "--replay") == 0)
+        {
+          replay_file = argv[++i];
+        }
+      else
+        {
+          std::cerr << argv[0] << ": invalid argument '" << arg << "'" << std::endl;
+          print_usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+    }
+
+  std::vector<ScriptSegment> script;
+  try
+    {
+      script = parse_script(script_text);
+    }
+  catch(const std::exception& err)
+    {
+      std::cerr << argv[0] << ": " << err.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  try
+    {
+      // reject every option the selected run mode would ignore before
+      // dispatching, only the single player script run records its
+      // input or supports a streamed map
+      const Option stream_option = { "--stream", stream_bytes > 0 };
+      const Option save_option = { "--save-level", !save_file.empty() };
+      const Option record_option = { "--record", !record_file.empty() };
+      const Option replay_option = { "--replay", !replay_file.empty() };
+      const Option fixed_option = { "--fixed", fixed };
+      const Option bodies_option = { "--bodies", num_bodies > 0 };
+      const Option swept_option = { "--swept", swept };
+      const Option ticks_option = { "--ticks", ticks_given };
+      const Option delta_option = { "--delta", delta_given };
+      const Option script_option = { "--script", script_given };
+
+      if (stream_bytes > 0 && level_file.empty())
+        throw std::runtime_error("--stream requires --level");
+      if (threads_given && num_bodies == 0)
+        throw std::runtime_error("--threads requires --bodies");
+
+      check_conflicts(stream_option, { save_option, record_option, replay_option, fixed_option, bodies_option });
+      check_conflicts(record_option, { save_option, replay_option, fixed_option, bodies_option });
+      check_conflicts(save_option, { replay_option, fixed_option, bodies_option, swept_option,
+                                     ticks_option, delta_option, script_option });
+      check_conflicts(replay_option, { fixed_option, bodies_option, swept_option,
+                                       ticks_option, delta_option, script_option });
+      check_conflicts(fixed_option, { bodies_option, swept_option });
+      check_conflicts(bodies_option, { swept_option });
+
+      if (stream_bytes > 0)
+        {
+          LevelFileInfo info = read_level_file_info(level_file);
+          std::unique_ptr<ChunkLoader> loader(new FileChunkLoader(level_file, info.width, info.height,
+                                                                  info.data_offset));
+          ChunkedTileMap map(std::move(loader), stream_bytes, info.tile_shift);
+          simulate(map, script, ticks, delta, swept, nullptr);
+          print_stats(map);
+        }
+      else
+        {
+          TileMap map = level_file.empty() ? default_level() : load_level_file(level_file);
+          if (!save_file.empty())
+            save_level_file(save_file, map);
+          else if (!replay_file.empty())
+            replay(SolidMap(map), load_input_log(replay_file));
+          else if (fixed)
+            simulate_fixed(SolidMap(map), script, ticks, delta);
+          else if (num_bodies > 0)
+            simulate_world(SolidMap(map), script, ticks, delta, num_bodies, num_threads);
+          else
+            {
+              // the log stores whole milliseconds, only accept a delta
+              // that a replay reproduces exactly
+              const uint32_t step_ms = static_cast<uint32_t>(std::lround(delta * 1000.0f));
+              InputLog log(step_ms, swept ? InputLog::STEP_SWEPT : InputLog::STEP_REVERT);
+              if (!record_file.empty() && (step_ms == 0 || log.get_delta() != delta))
+                throw std::runtime_error("--record requires a --delta of whole milliseconds");
+
+              simulate(SolidMap(map), script, ticks, delta, swept, record_file.empty() ? nullptr : &log);
+              if (!record_file.empty())
+                save_input_log(record_file, log);
+            }
+        }
+    }
+  catch(const std::exception& err)
+    {
+      std::cerr << argv[0] << ": " << err.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+/* EOF */
@@ -1,46 +1,100 @@
 #include "jumpnrun.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <SDL.h>
-#include <SDL_image.h>
 #include <SDL_tty.h>
 #include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "body.hpp"
+#include "camera.hpp"
+#include "font_data.hpp"
+#include "frame_profiler.hpp"
+#include "input_log.hpp"
+#include "level.hpp"
+#include "level_file.hpp"
+#include "packed_font.hpp"
+#include "physics.hpp"
+#include "sim_clock.hpp"
+#include "solid_map.hpp"
 
-const char* level[] = {
-  "                    ",
-  "                    ",
-  "                    ",
-  "       #### ####    ",
-  "                    ",
-  "                    ",
-  "                    ",
-  "#        ######     ",
-  "                    ",
-  "                    ",
-  "#                   ",
-  "      ####      #   ",
-  "                    ",
-  "                    ",
-  "                    ",
-  "####################"
+SDL_Surface *screen;
+TTY* tty;
+
+/** The three pixel values of a bevelled rectangle */
+struct RectColors
+{
+  Uint32 normal;
+  Uint32 highlight;
+  Uint32 shadow;
 };
 
-char get_tile(float x, float y)
+/** Mapped colours by (r, g, b), so drawing doesn't call SDL_MapRGB()
+    per rectangle, the cache is dropped when the format of the screen
+    changes */
+class ColorCache
 {
-  if (x < 0 || x >= 20*32 ||
-      y < 0 || y >= 16*32)
-    {
-      return 'X';
-    }
-  else
-    {
-      return level[int(y/32)][int(x/32)];
-    }
-}
+private:
+  const SDL_PixelFormat* m_format;
+  Uint8 m_bits_per_pixel;
+  Uint32 m_masks[4];
+  std::unordered_map<Uint32, RectColors> m_colors;
 
-SDL_Surface *screen;
-TTY* tty;
+  static Uint8 saturate(int v)
+  {
+    return static_cast<Uint8>(std::min(std::max(v, 0), 255));
+  }
 
-void draw_rect(int x, int y, int w, int h, unsigned char r, unsigned char b, unsigned char g, bool down = false)
+  bool same_format(const SDL_PixelFormat* format) const
+  {
+    return
+      format == m_format &&
+      format->BitsPerPixel == m_bits_per_pixel &&
+      format->Rmask == m_masks[0] && format->Gmask == m_masks[1] &&
+      format->Bmask == m_masks[2] && format->Amask == m_masks[3];
+  }
+
+public:
+  ColorCache() :
+    m_format(0),
+    m_bits_per_pixel(0),
+    m_masks(),
+    m_colors()
+  {}
+
+  const RectColors& get(const SDL_PixelFormat* format, Uint8 r, Uint8 g, Uint8 b)
+  {
+    if (!same_format(format))
+      {
+        m_colors.clear();
+        m_format = format;
+        m_bits_per_pixel = format->BitsPerPixel;
+        m_masks[0] = format->Rmask;
+        m_masks[1] = format->Gmask;
+        m_masks[2] = format->Bmask;
+        m_masks[3] = format->Amask;
+      }
+
+    const Uint32 key = (Uint32(r) << 16) | (Uint32(g) << 8) | Uint32(b);
+    auto it = m_colors.find(key);
+    if (it == m_colors.end())
+      {
+        RectColors colors;
+        colors.normal    = SDL_MapRGB(format, r, g, b);
+        colors.highlight = SDL_MapRGB(format, saturate(r + 50), saturate(g + 50), saturate(b + 50));
+        colors.shadow    = SDL_MapRGB(format, saturate(r - 50), saturate(g - 50), saturate(b - 50));
+        it = m_colors.insert(std::make_pair(key, colors)).first;
+      }
+    return it->second;
+  }
+};
+
+ColorCache color_cache;
+
+void draw_rect(SDL_Surface* target, int x, int y, int w, int h, unsigned char r, unsigned char b, unsigned char g, bool down = false)
 {
   SDL_Rect rect;
 
@@ -48,9 +102,10 @@ void draw_rect(int x, int y, int w, int h, unsigned char r, unsigned char b, uns
   rect.y = y;
   rect.w = w;
 
-  Uint32 normal    = SDL_MapRGB(screen->format, r, g, b);
-  Uint32 highlight = SDL_MapRGB(screen->format, r + 50, g + 50, b + 50);
-  Uint32 shadow    = SDL_MapRGB(screen->format, r - 50, g - 50, b - 50);
+  const RectColors& colors = color_cache.get(target->format, r, g, b);
+  Uint32 normal    = colors.normal;
+  Uint32 highlight = colors.highlight;
+  Uint32 shadow    = colors.shadow;
 
   /*  if (down)
       {
@@ -61,153 +116,288 @@ void draw_rect(int x, int y, int w, int h, unsigned char r, unsigned char b, uns
 
   rect.h = h;
 
-  SDL_FillRect(screen, &rect, normal);
+  SDL_FillRect(target, &rect, normal);
 
   rect.w = 2;
-  SDL_FillRect(screen, &rect, highlight);
+  SDL_FillRect(target, &rect, highlight);
 
   rect.w = w;
   rect.h = 2;
-  SDL_FillRect(screen, &rect, highlight);
+  SDL_FillRect(target, &rect, highlight);
 
   rect.x = x + w - 2;
   rect.w = 2;
   rect.h = h;
-  SDL_FillRect(screen, &rect, shadow);
+  SDL_FillRect(target, &rect, shadow);
 
   rect.x = x;
   rect.w = w;
   rect.y = y + h - 2;
   rect.h = 2;
-  SDL_FillRect(screen, &rect, shadow);
+  SDL_FillRect(target, &rect, shadow);
 }
 
-class Player
+void draw_rect(int x, int y, int w, int h, unsigned char r, unsigned char b, unsigned char g, bool down = false)
 {
-public:
-  float x;
-  float y;
+  draw_rect(screen, x, y, w, h, r, b, g, down);
+}
 
-  float vel_x;
-  float vel_y;
-  bool jump;
-  bool duck;
+/** Every tile style drawn once into a single surface, so that drawing
+    a tile is one blit instead of five fills */
+class TileAtlas
+{
+private:
+  SDL_Surface* m_surface;
+  int m_tile_size;
 
-  enum Direction { LEFT, RIGHT, NONE } direction;
+  /** Position of each tile in the atlas, -1 for tiles that aren't drawn */
+  int m_index[256];
 
-  Player()
+public:
+  TileAtlas() :
+    m_surface(0),
+    m_tile_size(0),
+    m_index()
   {
-    x = 100;
-    y = 100;
-
-    vel_x = 0;
-    vel_y = 0;
-
-    jump = false;
-    duck = false;
-    direction = NONE;
+    std::fill(m_index, m_index + 256, -1);
   }
 
-  bool clean()
+  ~TileAtlas()
   {
-    return
-      get_tile(x-16, y)      != ' ' ||
-      get_tile(x-16, y - 31) != ' ' ||
-      get_tile(x+16, y)      != ' ' ||
-      get_tile(x+16, y - 31) != ' ' ||
-      (!duck &&
-       (get_tile(x-16, y - 63) != ' ' ||
-        get_tile(x+16, y - 63) != ' '));
+    SDL_FreeSurface(m_surface);
   }
 
-  void update(float delta)
+  /** Renders the tile styles in the format of the screen */
+  void build(int tile_size)
   {
-    //std::cout << "Delta: " << delta << std::endl;
-    if (!on_ground())
-      vel_y += 10 * delta;
-
-    if (jump)
-      vel_y = -5;
-
-    TTY_SetCursor(tty, 0, 28);
-    TTY_printf(tty, "Velocity: %3.2f %3.2f  %d  %d   \r",  vel_x, vel_y, get_tile(x, y), on_ground());
-
-    float last_x = x;
-    float last_y = y;
-
-    x += vel_x;
-
-    if (clean())
+    struct TileStyle
+    {
+      char tile;
+      unsigned char r, g, b;
+      bool down;
+    };
+
+    static const TileStyle styles[] = {
+      { ' ',  50,  50,  50, true },
+      { '#', 200, 200, 200, false }
+    };
+    const int count = static_cast<int>(sizeof(styles) / sizeof(styles[0]));
+
+    SDL_FreeSurface(m_surface);
+    const SDL_PixelFormat* format = screen->format;
+    m_surface = SDL_CreateRGBSurface(SDL_SWSURFACE, count * tile_size, tile_size, format->BitsPerPixel,
+                                     format->Rmask, format->Gmask, format->Bmask, format->Amask);
+    if (!m_surface)
       {
-        x = last_x;
-        vel_x = 0;
+        printf("Unable to create tile atlas: %s\n", SDL_GetError());
+        exit(EXIT_FAILURE);
       }
 
-    y += vel_y;
-    if (clean())
+    m_tile_size = tile_size;
+    std::fill(m_index, m_index + 256, -1);
+    for(int i = 0; i < count; ++i)
       {
-        y = last_y;
-        vel_y = 0;
+        const TileStyle& style = styles[i];
+        draw_rect(m_surface, i * tile_size, 0, tile_size, tile_size, style.r, style.b, style.g, style.down);
+        m_index[static_cast<unsigned char>(style.tile)] = i;
       }
+  }
 
-    switch(direction)
+  void draw(char tile, int x, int y) const
+  {
+    const int index = m_index[static_cast<unsigned char>(tile)];
+    if (index >= 0)
       {
-        case LEFT:
-          if (vel_x > -5.0f)
-            vel_x -= 10 * delta;
-          break;
-
-        case RIGHT:
-          if (vel_x < 5.0f)
-            vel_x += 10 * delta;
-          break;
-
-        case NONE:
-          vel_x -= vel_x * delta * 10.0f;
-          break;
+        SDL_Rect src;
+        src.x = static_cast<Sint16>(index * m_tile_size);
+        src.y = 0;
+        src.w = static_cast<Uint16>(m_tile_size);
+        src.h = static_cast<Uint16>(m_tile_size);
+
+        SDL_Rect dst;
+        dst.x = static_cast<Sint16>(x);
+        dst.y = static_cast<Sint16>(y);
+        SDL_BlitSurface(m_surface, &src, screen, &dst);
       }
   }
 
-  void draw()
-  {
-    if (duck)
-      draw_rect(int(x - 16), int(y - 32) - 16, 32, 32, 150, 200, 150);
-    else
-      draw_rect(int(x - 16), int(y - 64) - 16, 32, 64, 150, 200, 150);
+private:
+  TileAtlas(const TileAtlas&);
+  TileAtlas& operator=(const TileAtlas&);
+};
 
-    FNT_Print(tty->font, screen, (int)x, (int)y-16, FNT_ALIGN_CENTER, "Hello\nWorld");
-  }
+/** Rectangles changed in the current frame, passed to SDL_UpdateRects()
+    instead of flipping the whole screen */
+class DirtyRects
+{
+private:
+  std::vector<SDL_Rect> m_rects;
 
-  void left()
-  {
-    direction = LEFT;
-  }
+public:
+  DirtyRects() : m_rects() {}
 
-  void stop()
+  /** Adds the part of the given rectangle that is on the screen */
+  void add(int x, int y, int w, int h)
   {
-    direction = NONE;
+    const int x1 = std::max(x, 0);
+    const int y1 = std::max(y, 0);
+    const int x2 = std::min(x + w, screen->w);
+    const int y2 = std::min(y + h, screen->h);
+    if (x1 < x2 && y1 < y2)
+      {
+        SDL_Rect rect;
+        rect.x = static_cast<Sint16>(x1);
+        rect.y = static_cast<Sint16>(y1);
+        rect.w = static_cast<Uint16>(x2 - x1);
+        rect.h = static_cast<Uint16>(y2 - y1);
+        m_rects.push_back(rect);
+      }
   }
 
-  void right()
-  {
-    direction = RIGHT;
-  }
+  void add(const SDL_Rect& rect) { add(rect.x, rect.y, rect.w, rect.h); }
 
-  bool on_ground()
+  const std::vector<SDL_Rect>& get_rects() const { return m_rects; }
+  void clear() { m_rects.clear(); }
+
+  void update()
   {
-    return
-      vel_y == 0 &&
-      (get_tile(x + 16, y + 16) != ' ' ||
-       get_tile(x - 16, y + 16) != ' ');
+    if (!m_rects.empty())
+      SDL_UpdateRects(screen, static_cast<int>(m_rects.size()), m_rects.data());
   }
 };
 
+/** Returns the screen area covered by draw_player(), i.e. the box and
+    the label below it */
+SDL_Rect player_bounds(const Body& player, const Camera& camera)
+{
+  const int label_width = 5 * 16;
+  const int height = player.duck ? 32 : 64;
+  const int left = int(player.x) - camera.get_x() - label_width / 2 - 1;
+  const int top = int(player.y) - camera.get_y() - height - 1;
+
+  SDL_Rect rect;
+  rect.x = static_cast<Sint16>(left);
+  rect.y = static_cast<Sint16>(top);
+  rect.w = static_cast<Uint16>(label_width + 2);
+  rect.h = static_cast<Uint16>(height + 32 + 2);
+  return rect;
+}
+
+void draw_player(const Body& player, const Camera& camera)
+{
+  const int x = camera.get_x();
+  const int y = camera.get_y();
+
+  if (player.duck)
+    draw_rect(int(player.x - 16) - x, int(player.y - 32) - y, 32, 32, 150, 200, 150);
+  else
+    draw_rect(int(player.x - 16) - x, int(player.y - 64) - y, 32, 64, 150, 200, 150);
+
+  FNT_Print(tty->font, screen, (int)player.x - x, (int)player.y - y, FNT_ALIGN_CENTER, "Hello\nWorld");
+}
+
+#ifndef JNRCOL_NO_HUD
+/** Debug readout, taken once per rendered frame after all physics
+    steps of that frame have run */
+struct HudSnapshot
+{
+  float vel_x;
+  float vel_y;
+  int tile;
+  bool on_ground;
+  Uint32 steps;
+};
+
+/** Draws the readout into the TTY row 28 on top of \a background,
+    returns the area that was drawn */
+SDL_Rect draw_hud(SDL_Surface* background, const HudSnapshot& hud)
+{
+  SDL_Rect rect;
+  rect.x = 0;
+  rect.y = 28 * 16;
+  rect.w = static_cast<Uint16>(screen->w);
+  rect.h = 16;
+
+  SDL_Rect dst = rect;
+  SDL_BlitSurface(background, &rect, screen, &dst);
+  FNT_Print(tty->font, screen, 0, rect.y, FNT_ALIGN_LEFT, "Velocity: %3.2f %3.2f  %d  %d  %2u",
+            hud.vel_x, hud.vel_y, hud.tile, hud.on_ground, hud.steps);
+  return rect;
+}
+#endif
+
+/** Unpacks the embedded glyph sheet into an RGBA surface for
+    FNT_Create(), returns 0 on failure */
+SDL_Surface* create_font_surface()
+{
+  PackedFont font = PackedFont::from_memory(get_font_data(), get_font_data_size());
+
+  // masks for r, g, b, a in byte order, as written by unpack_rgba()
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+  const Uint32 rmask = 0xff000000, gmask = 0x00ff0000, bmask = 0x0000ff00, amask = 0x000000ff;
+#else
+  const Uint32 rmask = 0x000000ff, gmask = 0x0000ff00, bmask = 0x00ff0000, amask = 0xff000000;
+#endif
+
+  SDL_Surface* surface = SDL_CreateRGBSurface(SDL_SWSURFACE, font.get_width(), font.get_height(), 32,
+                                              rmask, gmask, bmask, amask);
+  if (!surface)
+    return 0;
+
+  SDL_LockSurface(surface);
+  font.unpack_rgba(static_cast<uint8_t*>(surface->pixels), surface->pitch);
+  SDL_UnlockSurface(surface);
+  return surface;
+}
+
+/** F1 toggles the profiler and prints a report when it is turned off,
+    F2 writes the recorded frames as a Chrome trace */
+void handle_profiler_key(FrameProfiler& profiler, int key)
+{
+  if (key == SDLK_F1)
+    {
+      if (profiler.is_enabled())
+        profiler.print_report(std::cout);
+      profiler.set_enabled(!profiler.is_enabled());
+      std::cout << "profiler " << (profiler.is_enabled() ? "enabled" : "disabled") << std::endl;
+    }
+  else if (key == SDLK_F2)
+    {
+      const char* trace_file = "jumpnrun-trace.json";
+      try
+        {
+          profiler.write_chrome_trace(trace_file);
+          std::cout << "wrote " << profiler.get_frame_count() << " frames to " << trace_file << std::endl;
+        }
+      catch(const std::exception& err)
+        {
+          std::cout << "Error: " << err.what() << std::endl;
+        }
+    }
+}
+
 class JumpnRun
 {
 private:
+  TileMap map;
+  SolidMap solid;
+
+  /** The level and the TTY text, which don't change while running, the
+      frame loop only restores the parts of it that it drew over */
+  SDL_Surface* background;
+
+  TileAtlas atlas;
+
+  /** Receives the input of every physics tick when not null */
+  InputLog* recording;
 
 public:
-  JumpnRun()
+  JumpnRun(const TileMap& map_, InputLog* recording_ = 0) :
+    map(map_),
+    solid(map_),
+    background(0),
+    atlas(),
+    recording(recording_)
   {
     screen = 0;
   }
@@ -221,8 +411,8 @@ public:
       }
     atexit(SDL_Quit);
 
-    screen = SDL_SetVideoMode(640, 480, 0,
-                              SDL_HWSURFACE|SDL_DOUBLEBUF);
+    // single buffered, SDL_UpdateRects() can't be used with SDL_DOUBLEBUF
+    screen = SDL_SetVideoMode(640, 480, 0, SDL_SWSURFACE);
 
     if ( screen == NULL )
       {
@@ -239,12 +429,10 @@ public:
     SDL_SetClipRect(screen, &rect);
 
     {
-      //SDL_Surface* temp = TTY_CreateRGBSurface(font8x12);
-      const char* font_file = "c64_16x16.png";
-      SDL_Surface* temp = IMG_Load(font_file);
+      SDL_Surface* temp = create_font_surface();
       if (!temp)
         {
-          printf("Error: Couldn't load %s\n", font_file);
+          printf("Error: Couldn't create the font surface: %s\n", SDL_GetError());
           exit(EXIT_FAILURE);
         }
 
@@ -260,88 +448,229 @@ public:
     TTY_printf(tty, "READY.\n\n");
   }
 
+  /** Draws the tiles visible through \a camera and the TTY text to the
+      screen and keeps a copy of it as background, only needed again
+      once the camera scrolls */
+  void render_background(const Camera& camera)
+  {
+    if (!background)
+      {
+        const SDL_PixelFormat* format = screen->format;
+        background = SDL_CreateRGBSurface(SDL_SWSURFACE, screen->w, screen->h, format->BitsPerPixel,
+                                          format->Rmask, format->Gmask, format->Bmask, format->Amask);
+        if (!background)
+          {
+            printf("Unable to create background surface: %s\n", SDL_GetError());
+            exit(EXIT_FAILURE);
+          }
+      }
+
+    const int tile_size = map.get_tile_size();
+    const TileRange range = camera.visible_tiles(map.get_width(), map.get_height(), map.get_tile_shift());
+
+    // the view is only larger than the world for small maps
+    if (range.x1 * tile_size - camera.get_x() < screen->w ||
+        range.y1 * tile_size - camera.get_y() < screen->h)
+      SDL_FillRect(screen, NULL, SDL_MapRGB(screen->format, 0, 0, 0));
+
+    for(int y = range.y0; y < range.y1; ++y)
+      for(int x = range.x0; x < range.x1; ++x)
+        atlas.draw(map.at(x, y), x*tile_size - camera.get_x(), y*tile_size - camera.get_y());
+    TTY_Blit(tty, screen, 0, 0);
+
+    SDL_BlitSurface(screen, NULL, background, NULL);
+  }
+
   void run()
   {
     bool quit = false;
     SDL_Event event;
-    Uint32 last_tick = 0;
-    Player player;
+    SimClock clock;
+    Body player;
+    Body prev_player = player;
+    DirtyRects dirty;
+    std::vector<SDL_Rect> last_drawn;
+    uint8_t input = 0;
+
+    const int tile_size = map.get_tile_size();
+    Camera camera(screen->w, screen->h, map.get_width() * tile_size, map.get_height() * tile_size);
+    camera.center_on(player.x, player.y - 32);
+
+    atlas.build(tile_size);
+    render_background(camera);
+    SDL_UpdateRect(screen, 0, 0, 0, 0);
+    clock.reset(SDL_GetTicks());
+    FrameProfiler profiler;
+    const int stage_input = profiler.add_stage("input");
+    const int stage_physics = profiler.add_stage("physics");
+    const int stage_background = profiler.add_stage("background");
+    const int stage_hud = profiler.add_stage("hud");
+    const int stage_player = profiler.add_stage("player");
+    const int stage_present = profiler.add_stage("present");
+
     while(!quit)
       {
-        while(SDL_PollEvent(&event))
-          {
-            switch(event.type)
-              {
-                case SDL_QUIT:
-                  quit = true;
-                  break;
-              }
-          }
+        profiler.begin_frame();
 
-        Uint8 *keystates = SDL_GetKeyState( NULL );
+        {
+          FrameProfiler::Scope scope(profiler, stage_input);
 
-        if (keystates[SDLK_LEFT])
-          player.left();
+          while(SDL_PollEvent(&event))
+            {
+              switch(event.type)
+                {
+                  case SDL_QUIT:
+                    quit = true;
+                    break;
+
+                  case SDL_KEYDOWN:
+                    handle_profiler_key(profiler, event.key.keysym.sym);
+                    break;
+                }
+            }
 
-        else if (keystates[SDLK_RIGHT])
-          player.right();
+          Uint8 *keystates = SDL_GetKeyState( NULL );
 
-        else
-          player.stop();
+          input = 0;
+          if (keystates[SDLK_LEFT])
+            input |= INPUT_LEFT;
+          else if (keystates[SDLK_RIGHT])
+            input |= INPUT_RIGHT;
 
-        if (keystates[SDLK_SPACE])
-          player.jump = true;
-        else
-          player.jump = false;
+          if (keystates[SDLK_SPACE])
+            input |= INPUT_JUMP;
 
-        if (player.on_ground())
-        {
           if (keystates[SDLK_DOWN])
-            player.duck = true;
-          else
-            player.duck = false;
+            input |= INPUT_DUCK;
         }
 
-        for(int y =  0; y < 16; ++y)
-          for(int x = 0; x < 20; ++x)
+        const Uint32 steps = clock.advance(SDL_GetTicks());
+        {
+          FrameProfiler::Scope scope(profiler, stage_physics);
+          for(Uint32 i = 0; i < steps; ++i)
             {
-              if (level[y][x] == ' ')
-                {
-                  draw_rect(x*32, y*32 - 16, 32, 32, 50, 50, 50, true);
-                }
-              else if (level[y][x] == '#')
+              // input is applied per tick, so that replaying the
+              // recorded ticks reproduces the session exactly
+              apply_input(solid, player, input);
+              if (recording)
+                recording->record(input);
+
+              prev_player = player;
+              body_step_swept(solid, player, BODY_REFERENCE_STEP);
+            }
+        }
+
+        const Body visible = interpolate_body(prev_player, player, clock.get_alpha());
+
+        {
+          FrameProfiler::Scope scope(profiler, stage_background);
+          dirty.clear();
+          if (camera.follow(visible.x, visible.y - 32))
+            {
+              render_background(camera);
+              dirty.add(0, 0, screen->w, screen->h);
+            }
+          else
+            {
+              // erase what was drawn last frame, the erased areas have to
+              // be updated as well
+              for(const SDL_Rect& rect : last_drawn)
                 {
-                  draw_rect(x*32, y*32 - 16, 32, 32, 200, 200, 200);
+                  SDL_Rect src = rect;
+                  SDL_Rect dst = rect;
+                  SDL_BlitSurface(background, &src, screen, &dst);
+                  dirty.add(rect);
                 }
             }
+          last_drawn.clear();
+        }
 
-        Uint32 tick = SDL_GetTicks();
-        float delta = (tick - last_tick)/1000.0f;
-        last_tick = tick;
+#ifndef JNRCOL_NO_HUD
+        {
+          FrameProfiler::Scope scope(profiler, stage_hud);
+          HudSnapshot hud;
+          hud.vel_x = player.vel_x;
+          hud.vel_y = player.vel_y;
+          hud.tile = map.get_tile(player.x, player.y);
+          hud.on_ground = body_on_ground(solid, player);
+          hud.steps = steps;
+          dirty.add(draw_hud(background, hud));
+        }
+#else
+        (void)stage_hud;
+#endif
 
-        while (delta > 0.0f)
-          {
-            player.update(0.01f);
-            delta -= 0.01f;
-          }
-        player.draw();
-        TTY_Blit(tty, screen, 0, 0);
-        SDL_Flip(screen);
+        {
+          FrameProfiler::Scope scope(profiler, stage_player);
+          draw_player(visible, camera);
+          last_drawn.push_back(player_bounds(visible, camera));
+          dirty.add(last_drawn.back());
+        }
+
+        {
+          FrameProfiler::Scope scope(profiler, stage_present);
+          dirty.update();
+        }
+
+        profiler.end_frame();
       }
+
+    if (profiler.is_enabled())
+      profiler.print_report(std::cout);
   }
 
   void deinit()
   {
+    SDL_FreeSurface(background);
     TTY_Free(tty);
   }
 };
 
 int main(int argc, char** argv)
 {
-  JumpnRun app;
+  std::string level_file;
+  std::string record_file;
+  for(int i = 1; i < argc; ++i)
+    {
+      if (i + 1 < argc && strcmp(argv[i], "--record") == 0)
+        record_file = argv[++i];
+      else
+        level_file = argv[i];
+    }
+
+  TileMap map = default_level();
+  if (!level_file.empty())
+    {
+      try
+        {
+          map = load_level_file(level_file);
+        }
+      catch(const std::exception& err)
+        {
+          printf("Error: %s\n", err.what());
+          exit(EXIT_FAILURE);
+        }
+    }
+
+  InputLog log;
+  JumpnRun app(map, record_file.empty() ? 0 : &log);
   app.init();
   app.run();
   app.deinit();
+
+  if (!record_file.empty())
+    {
+      try
+        {
+          save_input_log(record_file, log);
+        }
+      catch(const std::exception& err)
+        {
+          printf("Error: %s\n", err.what());
+          exit(EXIT_FAILURE);
+        }
+    }
+
   return 0;
 }
 
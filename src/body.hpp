@@ -0,0 +1,36 @@
+#ifndef HEADER_JNRCOL_BODY_HPP
+#define HEADER_JNRCOL_BODY_HPP
+
+/** A 32x64 pixel box (32x32 when ducking), (x, y) is the bottom center
+    of the box */
+class Body
+{
+public:
+  float x;
+  float y;
+
+  float vel_x;
+  float vel_y;
+  bool jump;
+  bool duck;
+
+  enum Direction { LEFT, RIGHT, NONE } direction;
+
+  Body() :
+    x(100),
+    y(100),
+    vel_x(0),
+    vel_y(0),
+    jump(false),
+    duck(false),
+    direction(NONE)
+  {}
+
+  void left()  { direction = LEFT; }
+  void stop()  { direction = NONE; }
+  void right() { direction = RIGHT; }
+};
+
+#endif
+
+/* EOF */
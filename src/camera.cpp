@@ -0,0 +1,72 @@
+#include "camera.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/** Moves \a offset the least amount so that \a pos is within
+    [offset + margin, offset + view - margin) */
+int follow_axis(int offset, int view, int margin, float pos)
+{
+  const int p = static_cast<int>(std::floor(pos));
+  if (p < offset + margin)
+    return p - margin;
+  else if (p >= offset + view - margin)
+    return p - view + margin + 1;
+  else
+    return offset;
+}
+
+} // namespace
+
+Camera::Camera(int view_width, int view_height, int world_width, int world_height) :
+  m_view_width(view_width),
+  m_view_height(view_height),
+  m_world_width(world_width),
+  m_world_height(world_height),
+  m_x(0),
+  m_y(0)
+{
+}
+
+bool
+Camera::follow(float x, float y)
+{
+  const int old_x = m_x;
+  const int old_y = m_y;
+
+  m_x = follow_axis(m_x, m_view_width, m_view_width / 3, x);
+  m_y = follow_axis(m_y, m_view_height, m_view_height / 4, y);
+  clamp();
+
+  return m_x != old_x || m_y != old_y;
+}
+
+void
+Camera::center_on(float x, float y)
+{
+  m_x = static_cast<int>(std::floor(x)) - m_view_width / 2;
+  m_y = static_cast<int>(std::floor(y)) - m_view_height / 2;
+  clamp();
+}
+
+void
+Camera::clamp()
+{
+  m_x = std::max(0, std::min(m_x, m_world_width - m_view_width));
+  m_y = std::max(0, std::min(m_y, m_world_height - m_view_height));
+}
+
+TileRange
+Camera::visible_tiles(int width, int height, int tile_shift) const
+{
+  TileRange range;
+  range.x0 = std::max(0, m_x >> tile_shift);
+  range.y0 = std::max(0, m_y >> tile_shift);
+  range.x1 = std::min(width, ((m_x + m_view_width - 1) >> tile_shift) + 1);
+  range.y1 = std::min(height, ((m_y + m_view_height - 1) >> tile_shift) + 1);
+  return range;
+}
+
+/* EOF */
@@ -0,0 +1,56 @@
+#ifndef HEADER_JNRCOL_CAMERA_HPP
+#define HEADER_JNRCOL_CAMERA_HPP
+
+/** A range of tiles, the end is exclusive */
+struct TileRange
+{
+  int x0;
+  int y0;
+  int x1;
+  int y1;
+};
+
+/** Scroll offset of a view of \a view_width x \a view_height pixels
+    into a world of \a world_width x \a world_height pixels. The camera
+    only moves once the target leaves a dead zone in the middle of the
+    view, and never shows anything outside of the world, unless the
+    world is smaller than the view. */
+class Camera
+{
+private:
+  int m_view_width;
+  int m_view_height;
+  int m_world_width;
+  int m_world_height;
+
+  int m_x;
+  int m_y;
+
+public:
+  Camera(int view_width, int view_height, int world_width, int world_height);
+
+  /** Scrolls so that (\a x, \a y) is within the dead zone, returns true
+      if the offset changed */
+  bool follow(float x, float y);
+
+  /** Scrolls so that (\a x, \a y) is centered, e.g. on startup */
+  void center_on(float x, float y);
+
+  /** World position of the top left corner of the view */
+  int get_x() const { return m_x; }
+  int get_y() const { return m_y; }
+
+  int get_view_width() const { return m_view_width; }
+  int get_view_height() const { return m_view_height; }
+
+  /** Returns the tiles of a map with \a width x \a height tiles that
+      intersect the view */
+  TileRange visible_tiles(int width, int height, int tile_shift) const;
+
+private:
+  void clamp();
+};
+
+#endif
+
+/* EOF */
@@ -0,0 +1,180 @@
+#include "chunked_tilemap.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "tilemap.hpp"
+
+FileChunkLoader::FileChunkLoader(const std::string& filename, int width, int height, uint64_t offset) :
+  m_fd(-1),
+  m_width(width),
+  m_height(height),
+  m_offset(offset)
+{
+  m_fd = ::open(filename.c_str(), O_RDONLY);
+  if (m_fd < 0)
+    {
+      throw std::runtime_error(filename + ": " + strerror(errno));
+    }
+}
+
+FileChunkLoader::~FileChunkLoader()
+{
+  ::close(m_fd);
+}
+
+void
+FileChunkLoader::load(int cx, int cy, char* tiles)
+{
+  const int size = ChunkedTileMap::CHUNK_SIZE;
+  const int x0 = cx * size;
+  const int y0 = cy * size;
+  const int w = std::max(0, std::min(size, m_width - x0));
+
+  std::fill(tiles, tiles + size * size, ' ');
+
+  for(int y = 0; y < size && y0 + y < m_height; ++y)
+    {
+      const uint64_t pos = m_offset +
+        static_cast<uint64_t>(y0 + y) * static_cast<uint64_t>(m_width) + static_cast<uint64_t>(x0);
+
+      char* dst = tiles + y * size;
+      ssize_t remaining = w;
+      while(remaining > 0)
+        {
+          ssize_t ret = ::pread(m_fd, dst, remaining, static_cast<off_t>(pos + (w - remaining)));
+          if (ret < 0 && errno == EINTR)
+            continue;
+          else if (ret <= 0)
+            throw std::runtime_error(std::string("FileChunkLoader: read failed: ") +
+                                     (ret < 0 ? strerror(errno) : "unexpected end of file"));
+          dst += ret;
+          remaining -= ret;
+        }
+    }
+}
+
+int
+MemoryChunkLoader::get_width() const
+{
+  return m_map.get_width();
+}
+
+int
+MemoryChunkLoader::get_height() const
+{
+  return m_map.get_height();
+}
+
+void
+MemoryChunkLoader::load(int cx, int cy, char* tiles)
+{
+  const int size = ChunkedTileMap::CHUNK_SIZE;
+  const int x0 = cx * size;
+  const int y0 = cy * size;
+  const int w = std::max(0, std::min(size, m_map.get_width() - x0));
+
+  std::fill(tiles, tiles + size * size, ' ');
+
+  for(int y = 0; y < size && y0 + y < m_map.get_height(); ++y)
+    {
+      const char* src = m_map.get_data() +
+        static_cast<size_t>(y0 + y) * static_cast<size_t>(m_map.get_width()) + static_cast<size_t>(x0);
+      std::copy(src, src + w, tiles + y * size);
+    }
+}
+
+ChunkedTileMap::ChunkedTileMap(std::unique_ptr<ChunkLoader> loader, size_t max_resident_bytes, int tile_shift) :
+  m_loader(std::move(loader)),
+  m_width(m_loader->get_width()),
+  m_height(m_loader->get_height()),
+  m_tile_shift(tile_shift),
+  m_width_px(static_cast<unsigned int>(m_width) << tile_shift),
+  m_height_px(static_cast<unsigned int>(m_height) << tile_shift),
+  m_max_chunks(std::max<size_t>(1, max_resident_bytes / (CHUNK_SIZE * CHUNK_SIZE))),
+  m_chunks(),
+  m_index(),
+  m_last_key(0),
+  m_last_tiles(nullptr),
+  m_stats()
+{
+  reset_stats();
+}
+
+void
+ChunkedTileMap::reset_stats()
+{
+  m_stats.hits = 0;
+  m_stats.misses = 0;
+  m_stats.evictions = 0;
+  m_stats.load_ns_total = 0;
+  m_stats.load_ns_max = 0;
+}
+
+const char*
+ChunkedTileMap::lookup_chunk(uint64_t key, int cx, int cy) const
+{
+  auto it = m_index.find(key);
+  if (it != m_index.end())
+    {
+      m_stats.hits += 1;
+      m_chunks.splice(m_chunks.begin(), m_chunks, it->second);
+    }
+  else
+    {
+      m_stats.misses += 1;
+
+      if (m_chunks.size() >= m_max_chunks)
+        {
+          // reuse the least recently used chunk
+          m_stats.evictions += 1;
+          m_index.erase(m_chunks.back().key);
+          m_chunks.splice(m_chunks.begin(), m_chunks, std::prev(m_chunks.end()));
+        }
+      else
+        {
+          m_chunks.push_front(Chunk{ 0, std::vector<char>(CHUNK_SIZE * CHUNK_SIZE) });
+        }
+
+      Chunk& chunk = m_chunks.front();
+      chunk.key = key;
+
+      auto start = std::chrono::steady_clock::now();
+      m_loader->load(cx, cy, chunk.tiles.data());
+      auto ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now() - start).count());
+      m_stats.load_ns_total += ns;
+      m_stats.load_ns_max = std::max(m_stats.load_ns_max, ns);
+
+      m_index[key] = m_chunks.begin();
+    }
+
+  m_last_key = key;
+  m_last_tiles = m_chunks.front().tiles.data();
+  return m_last_tiles;
+}
+
+void
+ChunkedTileMap::prefetch(float x, float y, float radius) const
+{
+  const float chunk_px = static_cast<float>(CHUNK_SIZE << m_tile_shift);
+  const int cx0 = std::max(0, static_cast<int>(std::floor((x - radius) / chunk_px)));
+  const int cy0 = std::max(0, static_cast<int>(std::floor((y - radius) / chunk_px)));
+  const int cx1 = std::min((m_width - 1) >> CHUNK_SHIFT, static_cast<int>(std::floor((x + radius) / chunk_px)));
+  const int cy1 = std::min((m_height - 1) >> CHUNK_SHIFT, static_cast<int>(std::floor((y + radius) / chunk_px)));
+
+  for(int cy = cy0; cy <= cy1; ++cy)
+    for(int cx = cx0; cx <= cx1; ++cx)
+      {
+        get_chunk(cx, cy);
+      }
+}
+
+/* EOF */
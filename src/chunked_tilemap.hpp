@@ -0,0 +1,206 @@
+#ifndef HEADER_JNRCOL_CHUNKED_TILEMAP_HPP
+#define HEADER_JNRCOL_CHUNKED_TILEMAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class TileMap;
+
+/** Source of tile data for a ChunkedTileMap */
+class ChunkLoader
+{
+public:
+  virtual ~ChunkLoader() {}
+
+  /** Map size in tiles */
+  virtual int get_width() const = 0;
+  virtual int get_height() const = 0;
+
+  /** Fills \a tiles (ChunkedTileMap::CHUNK_SIZE^2 bytes, row-major)
+      with the chunk at chunk coordinates \a cx, \a cy, tiles outside
+      of the map are filled with ' ' */
+  virtual void load(int cx, int cy, char* tiles) = 0;
+};
+
+/** Loads chunks from a raw row-major tile file via pread() */
+class FileChunkLoader : public ChunkLoader
+{
+private:
+  int m_fd;
+  int m_width;
+  int m_height;
+  uint64_t m_offset;
+
+public:
+  /** Opens \a filename, the tiles start at \a offset, throws
+      std::runtime_error on failure */
+  FileChunkLoader(const std::string& filename, int width, int height, uint64_t offset = 0);
+  ~FileChunkLoader() override;
+
+  int get_width() const override { return m_width; }
+  int get_height() const override { return m_height; }
+  void load(int cx, int cy, char* tiles) override;
+
+private:
+  FileChunkLoader(const FileChunkLoader&) = delete;
+  FileChunkLoader& operator=(const FileChunkLoader&) = delete;
+};
+
+/** Serves chunks from a TileMap that is fully in memory, mainly useful
+    for benchmarks and for comparing against the plain TileMap */
+class MemoryChunkLoader : public ChunkLoader
+{
+private:
+  const TileMap& m_map;
+
+public:
+  explicit MemoryChunkLoader(const TileMap& map) : m_map(map) {}
+
+  int get_width() const override;
+  int get_height() const override;
+  void load(int cx, int cy, char* tiles) override;
+};
+
+/** The radius for ChunkedTileMap::prefetch() around a Body, covers
+    the 32x64 box plus some distance for the next ticks of movement */
+const float BODY_PREFETCH_RADIUS = 128.0f;
+
+/** A tile map that keeps only a bounded number of CHUNK_SIZE x
+    CHUNK_SIZE regions resident, chunks are loaded on first access and
+    the least recently used one is evicted when the memory cap is
+    reached. Lookups have the same semantics as TileMap. */
+class ChunkedTileMap
+{
+public:
+  static const int CHUNK_SHIFT = 6;
+  static const int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+
+  struct Stats
+  {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t load_ns_total;
+    uint64_t load_ns_max;
+  };
+
+private:
+  struct Chunk
+  {
+    uint64_t key;
+    std::vector<char> tiles;
+  };
+
+  std::unique_ptr<ChunkLoader> m_loader;
+  int m_width;
+  int m_height;
+  int m_tile_shift;
+  unsigned int m_width_px;
+  unsigned int m_height_px;
+  size_t m_max_chunks;
+
+  /** Resident chunks, most recently used first */
+  mutable std::list<Chunk> m_chunks;
+  mutable std::unordered_map<uint64_t, std::list<Chunk>::iterator> m_index;
+
+  /** Most recently accessed chunk, consecutive probes nearly always
+      land in the same chunk, so this skips the hash lookup and the
+      LRU reordering */
+  mutable uint64_t m_last_key;
+  mutable const char* m_last_tiles;
+
+  mutable Stats m_stats;
+
+public:
+  /** \a max_resident_bytes caps the memory used for tile data, at
+      least one chunk is always kept */
+  ChunkedTileMap(std::unique_ptr<ChunkLoader> loader, size_t max_resident_bytes, int tile_shift = 5);
+
+  int get_width() const { return m_width; }
+  int get_height() const { return m_height; }
+  int get_tile_shift() const { return m_tile_shift; }
+  int get_tile_size() const { return 1 << m_tile_shift; }
+
+  size_t get_max_chunks() const { return m_max_chunks; }
+  size_t get_resident_chunks() const { return m_chunks.size(); }
+  const Stats& get_stats() const { return m_stats; }
+  void reset_stats();
+
+  /** Returns the tile at tile coordinates \a tx, \a ty */
+  char at(int tx, int ty) const
+  {
+    if ((static_cast<unsigned int>(tx) >= static_cast<unsigned int>(m_width)) |
+        (static_cast<unsigned int>(ty) >= static_cast<unsigned int>(m_height)))
+      return 'X';
+    else
+      return get_chunk(tx >> CHUNK_SHIFT, ty >> CHUNK_SHIFT)
+        [((ty & (CHUNK_SIZE - 1)) << CHUNK_SHIFT) | (tx & (CHUNK_SIZE - 1))];
+  }
+
+  /** Returns the tile at integer pixel position \a px, \a py */
+  char get_tile_px(int px, int py) const
+  {
+    if ((static_cast<unsigned int>(px) >= m_width_px) |
+        (static_cast<unsigned int>(py) >= m_height_px))
+      return 'X';
+    else
+      return at(px >> m_tile_shift, py >> m_tile_shift);
+  }
+
+  /** Returns the tile at pixel position \a x, \a y */
+  char get_tile(float x, float y) const
+  {
+    // reject out of range and NaN positions before the int conversion
+    if (!(x >= 0.0f && x < static_cast<float>(m_width_px) &&
+          y >= 0.0f && y < static_cast<float>(m_height_px)))
+      return 'X';
+    else
+      return get_tile_px(static_cast<int>(x), static_cast<int>(y));
+  }
+
+  /** Returns true if the tile at pixel position \a x, \a y is solid */
+  bool is_solid(float x, float y) const
+  {
+    return get_tile(x, y) != ' ';
+  }
+
+  /** Makes sure all chunks within \a radius pixels of \a x, \a y are
+      resident, call this with the player position ahead of the
+      collision queries to take the loading off the physics step */
+  void prefetch(float x, float y, float radius) const;
+
+private:
+  static uint64_t make_key(int cx, int cy)
+  {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cy)) << 32) | static_cast<uint32_t>(cx);
+  }
+
+  const char* get_chunk(int cx, int cy) const
+  {
+    const uint64_t key = make_key(cx, cy);
+    if (key == m_last_key && m_last_tiles)
+      {
+        m_stats.hits += 1;
+        return m_last_tiles;
+      }
+    else
+      {
+        return lookup_chunk(key, cx, cy);
+      }
+  }
+
+  const char* lookup_chunk(uint64_t key, int cx, int cy) const;
+
+private:
+  ChunkedTileMap(const ChunkedTileMap&) = delete;
+  ChunkedTileMap& operator=(const ChunkedTileMap&) = delete;
+};
+
+#endif
+
+/* EOF */
@@ -0,0 +1,61 @@
+#ifndef HEADER_JNRCOL_FIXED_HPP
+#define HEADER_JNRCOL_FIXED_HPP
+
+#include <cstdint>
+
+/** Signed fixed-point number with 16 fractional bits, stored in 64 bits
+    as 16.16 would limit positions to 32768 pixels (1024 tiles). All
+    operations are plain integer arithmetic, so results are bit-exact
+    regardless of compiler, flags or FPU state. Multiplication rounds
+    towards negative infinity, the product of the raw values has to fit
+    into 64 bits, which holds for velocities and timesteps but is not
+    meant for multiplying two positions. */
+class Fixed
+{
+public:
+  static const int FRAC_BITS = 16;
+  static const int64_t ONE = int64_t(1) << FRAC_BITS;
+
+  static Fixed from_raw(int64_t raw) { Fixed f; f.m_raw = raw; return f; }
+  static Fixed from_int(int value) { return from_raw(static_cast<int64_t>(value) * ONE); }
+
+  /** Conversion from float, only meant for setting up state from
+      outside of the simulation, as the rounding of a float input may
+      already differ between machines */
+  static Fixed from_float(float value) { return from_raw(static_cast<int64_t>(static_cast<double>(value) * ONE)); }
+
+private:
+  int64_t m_raw;
+
+public:
+  Fixed() : m_raw(0) {}
+
+  int64_t raw() const { return m_raw; }
+
+  /** Returns the largest integer not greater than the value */
+  int floor_int() const { return static_cast<int>(m_raw >> FRAC_BITS); }
+
+  float to_float() const { return static_cast<float>(m_raw) / static_cast<float>(ONE); }
+
+  Fixed operator-() const { return from_raw(-m_raw); }
+  Fixed operator+(Fixed rhs) const { return from_raw(m_raw + rhs.m_raw); }
+  Fixed operator-(Fixed rhs) const { return from_raw(m_raw - rhs.m_raw); }
+  Fixed operator*(Fixed rhs) const
+  {
+    return from_raw((m_raw * rhs.m_raw) >> FRAC_BITS);
+  }
+
+  Fixed& operator+=(Fixed rhs) { m_raw += rhs.m_raw; return *this; }
+  Fixed& operator-=(Fixed rhs) { m_raw -= rhs.m_raw; return *this; }
+
+  bool operator==(Fixed rhs) const { return m_raw == rhs.m_raw; }
+  bool operator!=(Fixed rhs) const { return m_raw != rhs.m_raw; }
+  bool operator<(Fixed rhs) const { return m_raw < rhs.m_raw; }
+  bool operator>(Fixed rhs) const { return m_raw > rhs.m_raw; }
+  bool operator<=(Fixed rhs) const { return m_raw <= rhs.m_raw; }
+  bool operator>=(Fixed rhs) const { return m_raw >= rhs.m_raw; }
+};
+
+#endif
+
+/* EOF */
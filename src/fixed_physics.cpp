@@ -0,0 +1,215 @@
+#include "fixed_physics.hpp"
+
+#include "solid_map.hpp"
+
+namespace {
+
+const Fixed TEN = Fixed::from_int(10);
+const Fixed FIVE = Fixed::from_int(5);
+const Fixed HALF_WIDTH = Fixed::from_int(16);
+
+/** The smallest representable step, used to stop a box just short of
+    the tile boundary it touches */
+const Fixed EPSILON = Fixed::from_raw(1);
+
+Fixed body_height(const FixedBody& body)
+{
+  return Fixed::from_int(body.duck ? 31 : 63);
+}
+
+/** Pixel position of the left edge of tile \a t */
+Fixed tile_edge(int t, int shift)
+{
+  return Fixed::from_raw(static_cast<int64_t>(t) * (int64_t(1) << shift) * Fixed::ONE);
+}
+
+/** Returns true if any tile in the row at height \a y between \a left
+    and \a right is solid */
+bool row_solid(const SolidMap& map, Fixed left, Fixed right, Fixed y)
+{
+  const int shift = map.get_tile_shift();
+  return map.is_span_solid_tile(y.floor_int() >> shift, left.floor_int() >> shift, right.floor_int() >> shift);
+}
+
+bool column_solid(const SolidMap& map, const FixedBody& body, Fixed x)
+{
+  const int px = x.floor_int();
+  return
+    map.is_solid_px(px, body.y.floor_int()) ||
+    map.is_solid_px(px, (body.y - Fixed::from_int(31)).floor_int()) ||
+    (!body.duck && map.is_solid_px(px, (body.y - Fixed::from_int(63)).floor_int()));
+}
+
+/** Moves \a body by \a dx, stopping at the first solid column, returns
+    true on contact */
+bool sweep_x(const SolidMap& map, FixedBody& body, Fixed dx)
+{
+  const int shift = map.get_tile_shift();
+
+  if (dx > Fixed())
+    {
+      const int c0 = (body.x + HALF_WIDTH).floor_int() >> shift;
+      const int c1 = (body.x + HALF_WIDTH + dx).floor_int() >> shift;
+      for(int c = c0 + 1; c <= c1; ++c)
+        {
+          const Fixed edge = tile_edge(c, shift);
+          if (column_solid(map, body, edge))
+            {
+              body.x = edge - HALF_WIDTH - EPSILON;
+              return true;
+            }
+        }
+    }
+  else if (dx < Fixed())
+    {
+      const int c0 = (body.x - HALF_WIDTH).floor_int() >> shift;
+      const int c1 = (body.x - HALF_WIDTH + dx).floor_int() >> shift;
+      for(int c = c0 - 1; c >= c1; --c)
+        {
+          if (column_solid(map, body, tile_edge(c, shift)))
+            {
+              body.x = tile_edge(c + 1, shift) + HALF_WIDTH;
+              return true;
+            }
+        }
+    }
+
+  body.x += dx;
+  return false;
+}
+
+bool sweep_y(const SolidMap& map, FixedBody& body, Fixed dy)
+{
+  const int shift = map.get_tile_shift();
+  const Fixed height = body_height(body);
+
+  if (dy > Fixed())
+    {
+      const int r0 = body.y.floor_int() >> shift;
+      const int r1 = (body.y + dy).floor_int() >> shift;
+      for(int r = r0 + 1; r <= r1; ++r)
+        {
+          const Fixed edge = tile_edge(r, shift);
+          if (row_solid(map, body.x - HALF_WIDTH, body.x + HALF_WIDTH, edge))
+            {
+              body.y = edge - EPSILON;
+              return true;
+            }
+        }
+    }
+  else if (dy < Fixed())
+    {
+      const int r0 = (body.y - height).floor_int() >> shift;
+      const int r1 = (body.y - height + dy).floor_int() >> shift;
+      for(int r = r0 - 1; r >= r1; --r)
+        {
+          if (row_solid(map, body.x - HALF_WIDTH, body.x + HALF_WIDTH, tile_edge(r, shift)))
+            {
+              body.y = tile_edge(r + 1, shift) + height;
+              return true;
+            }
+        }
+    }
+
+  body.y += dy;
+  return false;
+}
+
+/** Returns \a vel * \a delta / FIXED_REFERENCE_STEP, rounded towards zero */
+Fixed scaled_move(Fixed vel, Fixed delta)
+{
+  if (delta == FIXED_REFERENCE_STEP)
+    return vel;
+  else
+    return Fixed::from_raw(vel.raw() * delta.raw() / FIXED_REFERENCE_STEP.raw());
+}
+
+} // namespace
+
+Body
+FixedBody::to_body() const
+{
+  Body body;
+  body.x = x.to_float();
+  body.y = y.to_float();
+  body.vel_x = vel_x.to_float();
+  body.vel_y = vel_y.to_float();
+  body.jump = jump;
+  body.duck = duck;
+  body.direction = direction;
+  return body;
+}
+
+bool fixed_body_overlaps(const SolidMap& map, const FixedBody& body)
+{
+  const Fixed left = body.x - HALF_WIDTH;
+  const Fixed right = body.x + HALF_WIDTH;
+
+  return
+    row_solid(map, left, right, body.y) ||
+    row_solid(map, left, right, body.y - Fixed::from_int(31)) ||
+    (!body.duck && row_solid(map, left, right, body.y - Fixed::from_int(63)));
+}
+
+bool fixed_body_on_ground(const SolidMap& map, const FixedBody& body)
+{
+  return
+    body.vel_y == Fixed() &&
+    row_solid(map, body.x - HALF_WIDTH, body.x + HALF_WIDTH, body.y + HALF_WIDTH);
+}
+
+void fixed_body_step(const SolidMap& map, FixedBody& body, Fixed delta)
+{
+  if (!fixed_body_on_ground(map, body))
+    body.vel_y += TEN * delta;
+
+  if (body.jump)
+    body.vel_y = -FIVE;
+
+  if (fixed_body_overlaps(map, body))
+    {
+      // already stuck, revert on overlap like body_step_swept()
+      const Fixed last_x = body.x;
+      body.x += scaled_move(body.vel_x, delta);
+      if (fixed_body_overlaps(map, body))
+        {
+          body.x = last_x;
+          body.vel_x = Fixed();
+        }
+
+      const Fixed last_y = body.y;
+      body.y += scaled_move(body.vel_y, delta);
+      if (fixed_body_overlaps(map, body))
+        {
+          body.y = last_y;
+          body.vel_y = Fixed();
+        }
+    }
+  else
+    {
+      if (sweep_x(map, body, scaled_move(body.vel_x, delta)))
+        body.vel_x = Fixed();
+
+      if (sweep_y(map, body, scaled_move(body.vel_y, delta)))
+        body.vel_y = Fixed();
+    }
+
+  switch(body.direction)
+    {
+      case Body::LEFT:
+        if (body.vel_x > -FIVE)
+          body.vel_x -= TEN * delta;
+        break;
+
+      case Body::RIGHT:
+        if (body.vel_x < FIVE)
+          body.vel_x += TEN * delta;
+        break;
+
+      case Body::NONE:
+        body.vel_x -= body.vel_x * delta * TEN;
+        break;
+    }
+}
+
+/* EOF */
@@ -0,0 +1,56 @@
+#ifndef HEADER_JNRCOL_FIXED_PHYSICS_HPP
+#define HEADER_JNRCOL_FIXED_PHYSICS_HPP
+
+#include "body.hpp"
+#include "fixed.hpp"
+
+class SolidMap;
+
+/** The fixed-point counterpart of BODY_REFERENCE_STEP, 655/65536 is the
+    closest value to 0.01 */
+const Fixed FIXED_REFERENCE_STEP = Fixed::from_raw(655);
+
+/** Fixed-point version of Body for deterministic simulation, e.g. for
+    replaying input logs or lockstep networking */
+class FixedBody
+{
+public:
+  Fixed x;
+  Fixed y;
+
+  Fixed vel_x;
+  Fixed vel_y;
+  bool jump;
+  bool duck;
+
+  Body::Direction direction;
+
+  FixedBody() :
+    x(Fixed::from_int(100)),
+    y(Fixed::from_int(100)),
+    vel_x(),
+    vel_y(),
+    jump(false),
+    duck(false),
+    direction(Body::NONE)
+  {}
+
+  void left()  { direction = Body::LEFT; }
+  void stop()  { direction = Body::NONE; }
+  void right() { direction = Body::RIGHT; }
+
+  /** Returns a float copy, e.g. for rendering */
+  Body to_body() const;
+};
+
+/* Same semantics as body_overlaps(), body_on_ground() and
+   body_step_swept(), computed entirely in integer arithmetic, so the
+   result is bit-identical on every machine. */
+
+bool fixed_body_overlaps(const SolidMap& map, const FixedBody& body);
+bool fixed_body_on_ground(const SolidMap& map, const FixedBody& body);
+void fixed_body_step(const SolidMap& map, FixedBody& body, Fixed delta);
+
+#endif
+
+/* EOF */
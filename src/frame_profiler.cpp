@@ -0,0 +1,218 @@
+#include "frame_profiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+FrameProfiler::StageStats compute_stats(const std::string& name, std::vector<int64_t>& durations)
+{
+  FrameProfiler::StageStats stats;
+  stats.name = name;
+  stats.frames = durations.size();
+  stats.min = 0.0;
+  stats.mean = 0.0;
+  stats.p99 = 0.0;
+
+  if (!durations.empty())
+    {
+      int64_t total = 0;
+      for(int64_t d : durations)
+        total += d;
+
+      const size_t p99_index = (durations.size() * 99 + 99) / 100 - 1;
+      std::nth_element(durations.begin(), durations.begin() + p99_index, durations.end());
+
+      stats.min = static_cast<double>(*std::min_element(durations.begin(), durations.end())) / 1e6;
+      stats.mean = static_cast<double>(total) / static_cast<double>(durations.size()) / 1e6;
+      stats.p99 = static_cast<double>(durations[p99_index]) / 1e6;
+    }
+
+  return stats;
+}
+
+std::string json_escape(const std::string& text)
+{
+  std::string out;
+  for(char c : text)
+    {
+      if (c == '"' || c == '\\')
+        out += '\\';
+      out += c;
+    }
+  return out;
+}
+
+void write_event(std::ostream& out, bool& first, const std::string& name, int64_t start_ns, int64_t duration_ns)
+{
+  // timestamps are in microseconds
+  out << (first ? "\n" : ",\n")
+      << "  { \"name\": \"" << json_escape(name) << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1"
+      << ", \"ts\": " << static_cast<double>(start_ns) / 1000.0
+      << ", \"dur\": " << static_cast<double>(duration_ns) / 1000.0 << " }";
+  first = false;
+}
+
+} // namespace
+
+FrameProfiler::FrameProfiler(size_t capacity) :
+  m_enabled(false),
+  m_capacity(std::max(capacity, size_t(1))),
+  m_stages(),
+  m_epoch(Clock::now()),
+  m_frame_start(m_capacity),
+  m_frame_duration(m_capacity),
+  m_stage_start(),
+  m_stage_duration(),
+  m_current(0),
+  m_count(0),
+  m_in_frame(false)
+{
+}
+
+int
+FrameProfiler::add_stage(const std::string& name)
+{
+  m_stages.push_back(name);
+  m_stage_start.assign(m_capacity * m_stages.size(), -1);
+  m_stage_duration.assign(m_capacity * m_stages.size(), 0);
+  m_current = 0;
+  m_count = 0;
+  m_in_frame = false;
+  return static_cast<int>(m_stages.size() - 1);
+}
+
+void
+FrameProfiler::set_enabled(bool enabled)
+{
+  m_enabled = enabled;
+  m_in_frame = false;
+}
+
+void
+FrameProfiler::begin_frame()
+{
+  if (!m_enabled)
+    return;
+
+  const size_t num_stages = m_stages.size();
+  std::fill(m_stage_start.begin() + m_current * num_stages,
+            m_stage_start.begin() + (m_current + 1) * num_stages, -1);
+  std::fill(m_stage_duration.begin() + m_current * num_stages,
+            m_stage_duration.begin() + (m_current + 1) * num_stages, 0);
+
+  m_frame_start[m_current] = to_ns(Clock::now());
+  m_in_frame = true;
+}
+
+void
+FrameProfiler::end_frame()
+{
+  if (!m_enabled || !m_in_frame)
+    return;
+
+  m_frame_duration[m_current] = to_ns(Clock::now()) - m_frame_start[m_current];
+  m_current = (m_current + 1) % m_capacity;
+  m_count = std::min(m_count + 1, m_capacity);
+  m_in_frame = false;
+}
+
+void
+FrameProfiler::record(int stage, Clock::time_point start, Clock::time_point end)
+{
+  if (!m_in_frame)
+    return;
+
+  const size_t i = m_current * m_stages.size() + static_cast<size_t>(stage);
+  if (m_stage_start[i] < 0)
+    m_stage_start[i] = to_ns(start);
+  m_stage_duration[i] += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+int64_t
+FrameProfiler::to_ns(Clock::time_point t) const
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(t - m_epoch).count();
+}
+
+size_t
+FrameProfiler::frame_index(size_t i) const
+{
+  return (m_current + m_capacity - m_count + i) % m_capacity;
+}
+
+std::vector<FrameProfiler::StageStats>
+FrameProfiler::get_stats() const
+{
+  std::vector<StageStats> result;
+  std::vector<int64_t> durations;
+  durations.reserve(m_count);
+
+  for(size_t i = 0; i < m_count; ++i)
+    durations.push_back(m_frame_duration[frame_index(i)]);
+  result.push_back(compute_stats("frame", durations));
+
+  for(size_t stage = 0; stage < m_stages.size(); ++stage)
+    {
+      durations.clear();
+      for(size_t i = 0; i < m_count; ++i)
+        {
+          const size_t j = frame_index(i) * m_stages.size() + stage;
+          if (m_stage_start[j] >= 0)
+            durations.push_back(m_stage_duration[j]);
+        }
+      result.push_back(compute_stats(m_stages[stage], durations));
+    }
+
+  return result;
+}
+
+void
+FrameProfiler::print_report(std::ostream& out) const
+{
+  // formatted into a local stream, so the flags of out stay untouched
+  std::ostringstream text;
+  text << "stage           frames    min ms   mean ms    p99 ms\n"
+       << std::fixed << std::setprecision(3);
+  for(const StageStats& stats : get_stats())
+    {
+      text << std::left << std::setw(14) << stats.name << std::right
+           << std::setw(8) << stats.frames
+           << std::setw(10) << stats.min
+           << std::setw(10) << stats.mean
+           << std::setw(10) << stats.p99 << "\n";
+    }
+  out << text.str() << std::flush;
+}
+
+void
+FrameProfiler::write_chrome_trace(const std::string& filename) const
+{
+  std::ofstream out(filename.c_str());
+  if (!out)
+    throw std::runtime_error(filename + ": couldn't open for writing");
+
+  out << "{ \"traceEvents\": [";
+  bool first = true;
+  for(size_t i = 0; i < m_count; ++i)
+    {
+      const size_t frame = frame_index(i);
+      write_event(out, first, "frame", m_frame_start[frame], m_frame_duration[frame]);
+      for(size_t stage = 0; stage < m_stages.size(); ++stage)
+        {
+          const size_t j = frame * m_stages.size() + stage;
+          if (m_stage_start[j] >= 0)
+            write_event(out, first, m_stages[stage], m_stage_start[j], m_stage_duration[j]);
+        }
+    }
+  out << "\n], \"displayTimeUnit\": \"ms\" }\n";
+
+  if (!out)
+    throw std::runtime_error(filename + ": write error");
+}
+
+/* EOF */
@@ -0,0 +1,114 @@
+#ifndef HEADER_JNRCOL_FRAME_PROFILER_HPP
+#define HEADER_JNRCOL_FRAME_PROFILER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/** Records how long each stage of the last \a capacity frames took. A
+    stage that is entered several times per frame is summed up. When
+    disabled, begin_frame(), end_frame() and Scope only check a flag. */
+class FrameProfiler
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  /** Times the enclosing block as part of \a stage */
+  class Scope
+  {
+  private:
+    FrameProfiler& m_profiler;
+    int m_stage;
+    Clock::time_point m_start;
+
+  public:
+    Scope(FrameProfiler& profiler, int stage) :
+      m_profiler(profiler),
+      m_stage(stage),
+      m_start(profiler.m_enabled ? Clock::now() : Clock::time_point())
+    {}
+
+    ~Scope()
+    {
+      if (m_profiler.m_enabled)
+        m_profiler.record(m_stage, m_start, Clock::now());
+    }
+
+  private:
+    Scope(const Scope&);
+    Scope& operator=(const Scope&);
+  };
+
+  struct StageStats
+  {
+    std::string name;
+    size_t frames;
+
+    /** Durations in milliseconds */
+    double min;
+    double mean;
+    double p99;
+  };
+
+private:
+  bool m_enabled;
+  size_t m_capacity;
+  std::vector<std::string> m_stages;
+  Clock::time_point m_epoch;
+
+  /** Ring buffer of frames, the stage values are stored as
+      [frame * num_stages + stage], times are nanoseconds since
+      m_epoch, a start of -1 marks a stage that didn't run */
+  std::vector<int64_t> m_frame_start;
+  std::vector<int64_t> m_frame_duration;
+  std::vector<int64_t> m_stage_start;
+  std::vector<int64_t> m_stage_duration;
+
+  size_t m_current;
+  size_t m_count;
+  bool m_in_frame;
+
+public:
+  FrameProfiler(size_t capacity = 600);
+
+  /** Adds a stage and returns its id, this discards the recorded
+      frames */
+  int add_stage(const std::string& name);
+
+  void set_enabled(bool enabled);
+  bool is_enabled() const { return m_enabled; }
+
+  void begin_frame();
+  void end_frame();
+
+  /** Number of complete frames in the buffer */
+  size_t get_frame_count() const { return m_count; }
+
+  /** Statistics over the frames in the buffer, the whole frame comes
+      first, followed by the stages in the order they were added */
+  std::vector<StageStats> get_stats() const;
+
+  /** Prints get_stats() as a table */
+  void print_report(std::ostream& out) const;
+
+  /** Writes the frames in the buffer in the Chrome trace event format,
+      as read by chrome://tracing and Perfetto, throws
+      std::runtime_error on failure */
+  void write_chrome_trace(const std::string& filename) const;
+
+private:
+  void record(int stage, Clock::time_point start, Clock::time_point end);
+  int64_t to_ns(Clock::time_point t) const;
+
+  /** Index of the \a i-th oldest frame in the ring buffer */
+  size_t frame_index(size_t i) const;
+
+  FrameProfiler(const FrameProfiler&);
+  FrameProfiler& operator=(const FrameProfiler&);
+};
+
+#endif
+
+/* EOF */
@@ -0,0 +1,105 @@
+#include "input_log.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+const char INPUT_MAGIC[4] = { 'J', 'N', 'R', 'I' };
+const uint32_t INPUT_VERSION = 1;
+const size_t INPUT_HEADER_SIZE = 20;
+
+uint32_t read_u32(const unsigned char* p)
+{
+  return
+    static_cast<uint32_t>(p[0]) |
+    (static_cast<uint32_t>(p[1]) << 8) |
+    (static_cast<uint32_t>(p[2]) << 16) |
+    (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void write_u32(unsigned char* p, uint32_t value)
+{
+  p[0] = static_cast<unsigned char>(value);
+  p[1] = static_cast<unsigned char>(value >> 8);
+  p[2] = static_cast<unsigned char>(value >> 16);
+  p[3] = static_cast<unsigned char>(value >> 24);
+}
+
+} // namespace
+
+InputLog load_input_log(const std::string& filename)
+{
+  std::ifstream in(filename, std::ios::binary);
+  if (!in)
+    throw std::runtime_error(filename + ": " + strerror(errno));
+
+  const std::vector<unsigned char> data((std::istreambuf_iterator<char>(in)),
+                                        std::istreambuf_iterator<char>());
+
+  if (data.size() < INPUT_HEADER_SIZE || memcmp(data.data(), INPUT_MAGIC, sizeof(INPUT_MAGIC)) != 0)
+    throw std::runtime_error(filename + ": not an input log");
+
+  if (read_u32(data.data() + 4) != INPUT_VERSION)
+    throw std::runtime_error(filename + ": unsupported input log version");
+
+  const uint32_t step_ms = read_u32(data.data() + 8);
+  const uint32_t num_ticks = read_u32(data.data() + 12);
+  const uint32_t step_mode = read_u32(data.data() + 16);
+  if (step_ms == 0)
+    throw std::runtime_error(filename + ": invalid tick length");
+  if (step_mode != InputLog::STEP_SWEPT && step_mode != InputLog::STEP_REVERT)
+    throw std::runtime_error(filename + ": unknown step mode");
+
+  InputLog log(step_ms, static_cast<InputLog::StepMode>(step_mode));
+  for(size_t i = INPUT_HEADER_SIZE; i + 1 < data.size(); i += 2)
+    {
+      const uint8_t input = data[i];
+      const unsigned int count = data[i + 1];
+      if (count == 0 || log.size() + count > num_ticks)
+        throw std::runtime_error(filename + ": corrupt input log");
+
+      for(unsigned int j = 0; j < count; ++j)
+        log.record(input);
+    }
+
+  if (log.size() != num_ticks)
+    throw std::runtime_error(filename + ": input log is truncated");
+
+  return log;
+}
+
+void save_input_log(const std::string& filename, const InputLog& log)
+{
+  std::vector<unsigned char> data(INPUT_HEADER_SIZE);
+  memcpy(data.data(), INPUT_MAGIC, sizeof(INPUT_MAGIC));
+  write_u32(data.data() + 4, INPUT_VERSION);
+  write_u32(data.data() + 8, log.get_step_ms());
+  write_u32(data.data() + 12, static_cast<uint32_t>(log.size()));
+  write_u32(data.data() + 16, log.get_step_mode());
+
+  for(size_t i = 0; i < log.size(); )
+    {
+      const uint8_t input = log.get(i);
+      size_t count = 1;
+      while(count < 255 && i + count < log.size() && log.get(i + count) == input)
+        ++count;
+
+      data.push_back(input);
+      data.push_back(static_cast<unsigned char>(count));
+      i += count;
+    }
+
+  std::ofstream out(filename, std::ios::binary);
+  if (!out)
+    throw std::runtime_error(filename + ": " + strerror(errno));
+
+  out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+  if (!out)
+    throw std::runtime_error(filename + ": write failed");
+}
+
+/* EOF */
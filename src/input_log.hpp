@@ -0,0 +1,106 @@
+#ifndef HEADER_JNRCOL_INPUT_LOG_HPP
+#define HEADER_JNRCOL_INPUT_LOG_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "body.hpp"
+#include "physics.hpp"
+
+/** The keys held during one physics tick */
+enum InputFlags : uint8_t
+{
+  INPUT_LEFT  = 1 << 0,
+  INPUT_RIGHT = 1 << 1,
+  INPUT_JUMP  = 1 << 2,
+  INPUT_DUCK  = 1 << 3
+};
+
+/** Feeds \a input to \a body, this is the one place where held keys
+    turn into body state, used by the game, the scripted runs and the
+    replay alike, for Body as well as FixedBody. Ducking only changes
+    while \a on_ground. */
+template<typename BodyType>
+void apply_input_flags(BodyType& body, uint8_t input, bool on_ground)
+{
+  if (input & INPUT_LEFT)
+    body.left();
+  else if (input & INPUT_RIGHT)
+    body.right();
+  else
+    body.stop();
+
+  body.jump = (input & INPUT_JUMP) != 0;
+
+  if (on_ground)
+    body.duck = (input & INPUT_DUCK) != 0;
+}
+
+template<typename Map>
+void apply_input(const Map& map, Body& body, uint8_t input)
+{
+  apply_input_flags(body, input, body_on_ground(map, body));
+}
+
+/** The input of every physics tick of a session, so it can be
+    replayed step by step */
+class InputLog
+{
+public:
+  /** The physics step the ticks were run with, a replay has to use the
+      same one to reproduce the session */
+  enum StepMode : uint32_t
+  {
+    STEP_SWEPT  = 0, ///< body_step_swept(), as used by the game
+    STEP_REVERT = 1  ///< body_step()
+  };
+
+private:
+  uint32_t m_step_ms;
+  StepMode m_step_mode;
+  std::vector<uint8_t> m_ticks;
+
+public:
+  InputLog(uint32_t step_ms = 10, StepMode step_mode = STEP_SWEPT) :
+    m_step_ms(step_ms),
+    m_step_mode(step_mode),
+    m_ticks()
+  {}
+
+  void record(uint8_t input) { m_ticks.push_back(input); }
+
+  uint32_t get_step_ms() const { return m_step_ms; }
+  StepMode get_step_mode() const { return m_step_mode; }
+
+  /** The timestep in seconds, as passed to the physics step */
+  float get_delta() const { return static_cast<float>(m_step_ms) / 1000.0f; }
+
+  size_t size() const { return m_ticks.size(); }
+  uint8_t get(size_t tick) const { return m_ticks[tick]; }
+};
+
+/* Binary input log format, all integers are little-endian:
+
+     offset  size  field
+          0     4  magic "JNRI"
+          4     4  version (1)
+          8     4  milliseconds per tick
+         12     4  number of ticks
+         16     4  step mode (0 = body_step_swept, 1 = body_step)
+         20     -  runs of (input flags, count) byte pairs, count is
+                   1 to 255, longer runs are split
+
+   Keys are usually held for many ticks, so a second of input is
+   typically a handful of bytes. */
+
+/** Reads \a filename, throws std::runtime_error on failure */
+InputLog load_input_log(const std::string& filename);
+
+/** Writes \a log to \a filename, throws std::runtime_error on failure */
+void save_input_log(const std::string& filename, const InputLog& log);
+
+#endif
+
+/* EOF */
@@ -0,0 +1,145 @@
+#include "job_system.hpp"
+
+#include <algorithm>
+
+JobSystem::JobSystem(unsigned int num_threads) :
+  m_queues(),
+  m_threads(),
+  m_mutex(),
+  m_wake(),
+  m_done(),
+  m_generation(0),
+  m_quit(false),
+  m_remaining(0)
+{
+  if (num_threads == 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  for(unsigned int i = 0; i < num_threads; ++i)
+    m_queues.emplace_back(new WorkQueue);
+
+  for(unsigned int i = 1; i < num_threads; ++i)
+    m_threads.emplace_back(&JobSystem::worker_main, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+  }
+  m_wake.notify_all();
+
+  for(auto& thread : m_threads)
+    thread.join();
+}
+
+void
+JobSystem::parallel_for(size_t count, size_t chunk_size, const RangeFunc& func)
+{
+  if (count == 0)
+    return;
+
+  chunk_size = std::max<size_t>(1, chunk_size);
+  const size_t num_chunks = (count + chunk_size - 1) / chunk_size;
+
+  if (m_queues.size() == 1)
+    {
+      for(size_t begin = 0; begin < count; begin += chunk_size)
+        func(begin, std::min(count, begin + chunk_size));
+      return;
+    }
+
+  m_remaining.store(num_chunks);
+
+  // hand out contiguous blocks of chunks so that each worker starts on
+  // its own part of the arrays
+  const size_t num_queues = m_queues.size();
+  for(size_t q = 0; q < num_queues; ++q)
+    {
+      WorkQueue& queue = *m_queues[q];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      for(size_t c = num_chunks * q / num_queues; c < num_chunks * (q + 1) / num_queues; ++c)
+        {
+          const size_t begin = c * chunk_size;
+          queue.tasks.push_back(Task{ begin, std::min(count, begin + chunk_size), &func });
+        }
+    }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_generation += 1;
+  }
+  m_wake.notify_all();
+
+  run_tasks(0);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this]{ return m_remaining.load() == 0; });
+}
+
+void
+JobSystem::worker_main(unsigned int index)
+{
+  uint64_t seen_generation = 0;
+  while(true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [&]{ return m_quit || m_generation != seen_generation; });
+        if (m_quit)
+          return;
+        seen_generation = m_generation;
+      }
+
+      run_tasks(index);
+    }
+}
+
+void
+JobSystem::run_tasks(unsigned int index)
+{
+  Task task;
+  while(pop_task(index, task))
+    {
+      (*task.func)(task.begin, task.end);
+
+      if (m_remaining.fetch_sub(1) == 1)
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          m_done.notify_all();
+        }
+    }
+}
+
+bool
+JobSystem::pop_task(unsigned int index, Task& task)
+{
+  {
+    WorkQueue& own = *m_queues[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty())
+      {
+        task = own.tasks.front();
+        own.tasks.pop_front();
+        return true;
+      }
+  }
+
+  const size_t num_queues = m_queues.size();
+  for(size_t i = 1; i < num_queues; ++i)
+    {
+      WorkQueue& victim = *m_queues[(index + i) % num_queues];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.tasks.empty())
+        {
+          task = victim.tasks.back();
+          victim.tasks.pop_back();
+          return true;
+        }
+    }
+
+  return false;
+}
+
+/* EOF */
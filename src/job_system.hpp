@@ -0,0 +1,76 @@
+#ifndef HEADER_JNRCOL_JOB_SYSTEM_HPP
+#define HEADER_JNRCOL_JOB_SYSTEM_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** A fixed pool of worker threads, each with its own task deque. A
+    worker takes tasks from the front of its own deque and, once that
+    is empty, steals from the back of the others. The calling thread
+    takes part in the work as worker 0. */
+class JobSystem
+{
+public:
+  typedef std::function<void (size_t begin, size_t end)> RangeFunc;
+
+private:
+  struct Task
+  {
+    size_t begin;
+    size_t end;
+    const RangeFunc* func;
+  };
+
+  struct WorkQueue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<WorkQueue>> m_queues;
+  std::vector<std::thread> m_threads;
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  uint64_t m_generation;
+  bool m_quit;
+
+  std::atomic<size_t> m_remaining;
+
+public:
+  /** Creates a pool of \a num_threads workers including the calling
+      thread, 0 uses one per hardware thread */
+  explicit JobSystem(unsigned int num_threads = 0);
+  ~JobSystem();
+
+  unsigned int get_num_threads() const { return static_cast<unsigned int>(m_queues.size()); }
+
+  /** Splits [0, \a count) into chunks of \a chunk_size and calls \a func
+      for each of them, returns once all chunks are done. The split
+      does not depend on the number of threads. */
+  void parallel_for(size_t count, size_t chunk_size, const RangeFunc& func);
+
+private:
+  void worker_main(unsigned int index);
+
+  /** Runs tasks until none are left in any queue */
+  void run_tasks(unsigned int index);
+  bool pop_task(unsigned int index, Task& task);
+
+private:
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+};
+
+#endif
+
+/* EOF */
@@ -0,0 +1,31 @@
+#include "level.hpp"
+
+namespace {
+
+const char* level[] = {
+  "                    ",
+  "                    ",
+  "                    ",
+  "       #### ####    ",
+  "                    ",
+  "                    ",
+  "                    ",
+  "#        ######     ",
+  "                    ",
+  "                    ",
+  "#                   ",
+  "      ####      #   ",
+  "                    ",
+  "                    ",
+  "                    ",
+  "####################"
+};
+
+} // namespace
+
+TileMap default_level()
+{
+  return TileMap::from_rows(level, 20, 16);
+}
+
+/* EOF */
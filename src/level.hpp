@@ -0,0 +1,11 @@
+#ifndef HEADER_JNRCOL_LEVEL_HPP
+#define HEADER_JNRCOL_LEVEL_HPP
+
+#include "tilemap.hpp"
+
+/** Returns the builtin 20x16 test level */
+TileMap default_level();
+
+#endif
+
+/* EOF */
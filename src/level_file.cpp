@@ -0,0 +1,157 @@
+#include "level_file.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char LEVEL_MAGIC[4] = { 'J', 'N', 'R', 'L' };
+const uint32_t LEVEL_VERSION = 1;
+const uint32_t LEVEL_HEADER_SIZE = 32;
+
+uint32_t read_u32(const unsigned char* p)
+{
+  return
+    static_cast<uint32_t>(p[0]) |
+    (static_cast<uint32_t>(p[1]) << 8) |
+    (static_cast<uint32_t>(p[2]) << 16) |
+    (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void write_u32(unsigned char* p, uint32_t value)
+{
+  p[0] = static_cast<unsigned char>(value);
+  p[1] = static_cast<unsigned char>(value >> 8);
+  p[2] = static_cast<unsigned char>(value >> 16);
+  p[3] = static_cast<unsigned char>(value >> 24);
+}
+
+LevelFileInfo parse_header(const std::string& filename, const unsigned char* header, uint64_t file_size)
+{
+  if (file_size < LEVEL_HEADER_SIZE || memcmp(header, LEVEL_MAGIC, sizeof(LEVEL_MAGIC)) != 0)
+    throw std::runtime_error(filename + ": not a level file");
+
+  if (read_u32(header + 4) != LEVEL_VERSION)
+    throw std::runtime_error(filename + ": unsupported level file version");
+
+  LevelFileInfo info;
+  const uint32_t width = read_u32(header + 8);
+  const uint32_t height = read_u32(header + 12);
+  const uint32_t tile_shift = read_u32(header + 16);
+  info.data_offset = read_u32(header + 20);
+
+  if (width == 0 || height == 0 || width > 0x7fffffff || height > 0x7fffffff ||
+      tile_shift > 16 || (static_cast<uint64_t>(width) << tile_shift) > 0xffffffffu ||
+      (static_cast<uint64_t>(height) << tile_shift) > 0xffffffffu)
+    throw std::runtime_error(filename + ": invalid level dimensions");
+
+  info.width = static_cast<int>(width);
+  info.height = static_cast<int>(height);
+  info.tile_shift = static_cast<int>(tile_shift);
+
+  if (info.data_offset < LEVEL_HEADER_SIZE ||
+      info.data_offset + static_cast<uint64_t>(width) * height > file_size)
+    throw std::runtime_error(filename + ": level file is truncated");
+
+  return info;
+}
+
+/** Owns a read-only mapping of a whole file */
+class FileMapping
+{
+private:
+  void* m_data;
+  size_t m_size;
+
+public:
+  FileMapping(void* data, size_t size) : m_data(data), m_size(size) {}
+  ~FileMapping() { munmap(m_data, m_size); }
+
+  const unsigned char* get_data() const { return static_cast<const unsigned char*>(m_data); }
+
+private:
+  FileMapping(const FileMapping&) = delete;
+  FileMapping& operator=(const FileMapping&) = delete;
+};
+
+} // namespace
+
+LevelFileInfo read_level_file_info(const std::string& filename)
+{
+  std::ifstream in(filename, std::ios::binary);
+  if (!in)
+    throw std::runtime_error(filename + ": " + strerror(errno));
+
+  in.seekg(0, std::ios::end);
+  const uint64_t file_size = static_cast<uint64_t>(in.tellg());
+  in.seekg(0, std::ios::beg);
+
+  unsigned char header[LEVEL_HEADER_SIZE] = {};
+  in.read(reinterpret_cast<char*>(header), sizeof(header));
+
+  return parse_header(filename, header, file_size);
+}
+
+TileMap load_level_file(const std::string& filename)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error(filename + ": " + strerror(errno));
+
+  struct stat st;
+  if (fstat(fd, &st) < 0)
+    {
+      int err = errno;
+      close(fd);
+      throw std::runtime_error(filename + ": " + strerror(err));
+    }
+
+  const size_t size = static_cast<size_t>(st.st_size);
+  if (size < LEVEL_HEADER_SIZE)
+    {
+      close(fd);
+      throw std::runtime_error(filename + ": not a level file");
+    }
+
+  void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  int err = errno;
+  close(fd);
+  if (data == MAP_FAILED)
+    throw std::runtime_error(filename + ": mmap failed: " + strerror(err));
+
+  auto mapping = std::make_shared<FileMapping>(data, size);
+  LevelFileInfo info = parse_header(filename, mapping->get_data(), size);
+
+  const char* tiles = reinterpret_cast<const char*>(mapping->get_data() + info.data_offset);
+  return TileMap::from_memory(mapping, tiles, info.width, info.height, info.tile_shift);
+}
+
+void save_level_file(const std::string& filename, const TileMap& map)
+{
+  unsigned char header[LEVEL_HEADER_SIZE] = {};
+  memcpy(header, LEVEL_MAGIC, sizeof(LEVEL_MAGIC));
+  write_u32(header + 4, LEVEL_VERSION);
+  write_u32(header + 8, static_cast<uint32_t>(map.get_width()));
+  write_u32(header + 12, static_cast<uint32_t>(map.get_height()));
+  write_u32(header + 16, static_cast<uint32_t>(map.get_tile_shift()));
+  write_u32(header + 20, LEVEL_HEADER_SIZE);
+
+  std::ofstream out(filename, std::ios::binary);
+  if (!out)
+    throw std::runtime_error(filename + ": " + strerror(errno));
+
+  out.write(reinterpret_cast<const char*>(header), sizeof(header));
+  out.write(map.get_data(),
+            static_cast<std::streamsize>(static_cast<size_t>(map.get_width()) *
+                                         static_cast<size_t>(map.get_height())));
+  if (!out)
+    throw std::runtime_error(filename + ": write failed");
+}
+
+/* EOF */
@@ -0,0 +1,47 @@
+#ifndef HEADER_JNRCOL_LEVEL_FILE_HPP
+#define HEADER_JNRCOL_LEVEL_FILE_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "tilemap.hpp"
+
+/* Binary level format, all integers are little-endian:
+
+     offset  size  field
+          0     4  magic "JNRL"
+          4     4  version (1)
+          8     4  width in tiles
+         12     4  height in tiles
+         16     4  tile shift (tile size is 1 << shift pixels)
+         20     4  offset of the tile data from the start of the file
+         24     -  padding up to the tile data
+
+   The tile data is width * height bytes in row-major order, one
+   character per tile as in TileMap. */
+
+struct LevelFileInfo
+{
+  int width;
+  int height;
+  int tile_shift;
+  uint64_t data_offset;
+};
+
+/** Reads and validates the header of \a filename, throws
+    std::runtime_error on failure */
+LevelFileInfo read_level_file_info(const std::string& filename);
+
+/** Maps \a filename into memory and returns a read-only TileMap that
+    uses the mapped tile data directly, so loading is independent of
+    the level size and the pages are shared between all processes
+    that have the same level open. Throws std::runtime_error on
+    failure. */
+TileMap load_level_file(const std::string& filename);
+
+/** Writes \a map to \a filename, throws std::runtime_error on failure */
+void save_level_file(const std::string& filename, const TileMap& map);
+
+#endif
+
+/* EOF */
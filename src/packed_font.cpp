@@ -0,0 +1,138 @@
+#include "packed_font.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+const char FONT_MAGIC[4] = { 'J', 'N', 'R', 'F' };
+const uint32_t FONT_VERSION = 1;
+const size_t FONT_HEADER_SIZE = 24;
+
+uint32_t read_u32(const uint8_t* p)
+{
+  return
+    static_cast<uint32_t>(p[0]) |
+    (static_cast<uint32_t>(p[1]) << 8) |
+    (static_cast<uint32_t>(p[2]) << 16) |
+    (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void write_u32(uint8_t* p, uint32_t value)
+{
+  p[0] = static_cast<uint8_t>(value);
+  p[1] = static_cast<uint8_t>(value >> 8);
+  p[2] = static_cast<uint8_t>(value >> 16);
+  p[3] = static_cast<uint8_t>(value >> 24);
+}
+
+} // namespace
+
+PackedFont::PackedFont() :
+  m_width(0),
+  m_height(0),
+  m_glyph_width(0),
+  m_glyph_height(0),
+  m_stride(0),
+  m_colors(nullptr),
+  m_bits(nullptr)
+{
+}
+
+PackedFont
+PackedFont::from_memory(const void* data, size_t size)
+{
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+
+  if (size < FONT_HEADER_SIZE || memcmp(p, FONT_MAGIC, sizeof(FONT_MAGIC)) != 0)
+    throw std::runtime_error("not a packed font");
+
+  if (read_u32(p + 4) != FONT_VERSION)
+    throw std::runtime_error("unsupported packed font version");
+
+  const uint32_t width = read_u32(p + 8);
+  const uint32_t height = read_u32(p + 12);
+  const uint32_t glyph_width = read_u32(p + 16);
+  const uint32_t glyph_height = read_u32(p + 20);
+
+  if (width == 0 || height == 0 || width > 0x8000 || height > 0x8000 ||
+      glyph_width == 0 || glyph_height == 0 || glyph_width > width || glyph_height > height)
+    throw std::runtime_error("invalid packed font dimensions");
+
+  PackedFont font;
+  font.m_width = static_cast<int>(width);
+  font.m_height = static_cast<int>(height);
+  font.m_glyph_width = static_cast<int>(glyph_width);
+  font.m_glyph_height = static_cast<int>(glyph_height);
+  font.m_stride = (width + 7) / 8;
+  font.m_colors = p + FONT_HEADER_SIZE;
+  font.m_bits = font.m_colors + 4 * static_cast<size_t>(height);
+
+  if (FONT_HEADER_SIZE + 4 * static_cast<size_t>(height) + font.m_stride * height > size)
+    throw std::runtime_error("packed font is truncated");
+
+  return font;
+}
+
+void
+PackedFont::unpack_rgba(uint8_t* pixels, size_t pitch) const
+{
+  for(int y = 0; y < m_height; ++y)
+    {
+      const uint8_t* color = m_colors + 4 * y;
+      uint8_t* out = pixels + static_cast<size_t>(y) * pitch;
+      for(int x = 0; x < m_width; ++x, out += 4)
+        {
+          if (is_set(x, y))
+            {
+              out[0] = color[0];
+              out[1] = color[1];
+              out[2] = color[2];
+              out[3] = 255;
+            }
+          else
+            {
+              out[0] = out[1] = out[2] = out[3] = 0;
+            }
+        }
+    }
+}
+
+std::vector<uint8_t> pack_font(const uint8_t* rgba, int width, int height, size_t pitch,
+                               int glyph_width, int glyph_height)
+{
+  const size_t stride = (static_cast<size_t>(width) + 7) / 8;
+  std::vector<uint8_t> data(FONT_HEADER_SIZE + 4 * static_cast<size_t>(height) + stride * height);
+
+  memcpy(data.data(), FONT_MAGIC, sizeof(FONT_MAGIC));
+  write_u32(data.data() + 4, FONT_VERSION);
+  write_u32(data.data() + 8, static_cast<uint32_t>(width));
+  write_u32(data.data() + 12, static_cast<uint32_t>(height));
+  write_u32(data.data() + 16, static_cast<uint32_t>(glyph_width));
+  write_u32(data.data() + 20, static_cast<uint32_t>(glyph_height));
+
+  uint8_t* colors = data.data() + FONT_HEADER_SIZE;
+  uint8_t* bits = colors + 4 * static_cast<size_t>(height);
+  for(int y = 0; y < height; ++y)
+    {
+      const uint8_t* row = rgba + static_cast<size_t>(y) * pitch;
+      bool has_color = false;
+      for(int x = 0; x < width; ++x)
+        {
+          const uint8_t* px = row + 4 * x;
+          if (px[3] >= 128)
+            {
+              if (!has_color)
+                {
+                  memcpy(colors + 4 * y, px, 3);
+                  has_color = true;
+                }
+              bits[static_cast<size_t>(y) * stride + (x >> 3)] |= static_cast<uint8_t>(0x80 >> (x & 7));
+            }
+        }
+    }
+
+  return data;
+}
+
+/* EOF */
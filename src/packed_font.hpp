@@ -0,0 +1,70 @@
+#ifndef HEADER_JNRCOL_PACKED_FONT_HPP
+#define HEADER_JNRCOL_PACKED_FONT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Packed glyph sheet format, all integers are little-endian:
+
+     offset  size  field
+          0     4  magic "JNRF"
+          4     4  version (1)
+          8     4  sheet width in pixels
+         12     4  sheet height in pixels
+         16     4  glyph width
+         20     4  glyph height
+         24  4 * h  colour of each scanline as r, g, b, 0
+          -     -  the mask, one bit per pixel, (width + 7) / 8 bytes
+                   per row, most significant bit first
+
+   Glyph sheets have a single colour per scanline (the C64 font has a
+   vertical gradient) and either opaque or transparent pixels, so this
+   is lossless for them at 1/32 of the size of RGBA. */
+
+/** Read-only view of a packed glyph sheet, e.g. one embedded into the
+    executable */
+class PackedFont
+{
+private:
+  int m_width;
+  int m_height;
+  int m_glyph_width;
+  int m_glyph_height;
+  size_t m_stride;
+  const uint8_t* m_colors;
+  const uint8_t* m_bits;
+
+public:
+  /** Validates \a data, which has to stay alive as long as the
+      PackedFont is used, throws std::runtime_error on failure */
+  static PackedFont from_memory(const void* data, size_t size);
+
+private:
+  PackedFont();
+
+public:
+  int get_width() const { return m_width; }
+  int get_height() const { return m_height; }
+  int get_glyph_width() const { return m_glyph_width; }
+  int get_glyph_height() const { return m_glyph_height; }
+
+  bool is_set(int x, int y) const
+  {
+    return (m_bits[static_cast<size_t>(y) * m_stride + (static_cast<size_t>(x) >> 3)] >> (7 - (x & 7))) & 1;
+  }
+
+  /** Writes the sheet as r, g, b, a bytes, \a pitch bytes per row,
+      unset pixels are transparent black */
+  void unpack_rgba(uint8_t* pixels, size_t pitch) const;
+};
+
+/** Packs an RGBA glyph sheet with \a pitch bytes per row, pixels with
+    an alpha of 128 or more are set and take the colour of the first
+    set pixel in their scanline */
+std::vector<uint8_t> pack_font(const uint8_t* rgba, int width, int height, size_t pitch,
+                               int glyph_width, int glyph_height);
+
+#endif
+
+/* EOF */
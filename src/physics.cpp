@@ -0,0 +1,292 @@
+#include "physics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "body.hpp"
+#include "chunked_tilemap.hpp"
+#include "solid_map.hpp"
+#include "tilemap.hpp"
+
+namespace {
+
+/** Returns true if the row at height \a y is solid at \a left or \a right */
+template<typename Map>
+bool row_solid(const Map& map, float left, float right, float y)
+{
+  return map.is_solid(left, y) || map.is_solid(right, y);
+}
+
+/** Tests the whole span with word operations instead of probing the
+    two ends, for a 32 pixel wide body on 32 pixel tiles these are the
+    same two tiles */
+bool row_solid(const SolidMap& map, float left, float right, float y)
+{
+  return map.is_span_solid(left, right, y);
+}
+
+} // namespace
+
+template<typename Map>
+bool body_overlaps(const Map& map, const Body& body)
+{
+  const float x = body.x;
+  const float y = body.y;
+
+  return
+    row_solid(map, x - 16, x + 16, y) ||
+    row_solid(map, x - 16, x + 16, y - 31) ||
+    (!body.duck && row_solid(map, x - 16, x + 16, y - 63));
+}
+
+template<typename Map>
+bool body_on_ground(const Map& map, const Body& body)
+{
+  return
+    body.vel_y == 0 &&
+    row_solid(map, body.x - 16, body.x + 16, body.y + 16);
+}
+
+namespace {
+
+/** Returns the largest position for which position + \a offset is
+    still strictly below \a edge, the probes treat a point on a tile
+    boundary as inside the lower/right tile, so this is the closest a
+    box can get to a tile from above or the left */
+float flush_below(float edge, float offset)
+{
+  float pos = edge - offset;
+  while(pos + offset >= edge)
+    pos = std::nextafter(pos, -std::numeric_limits<float>::infinity());
+  return pos;
+}
+
+int to_tile(float v, int tile_shift)
+{
+  return static_cast<int>(std::floor(v)) >> tile_shift;
+}
+
+/** Returns true if the column at pixel \a px is solid at any of the
+    heights probed by body_overlaps() */
+template<typename Map>
+bool column_solid(const Map& map, const Body& body, float px)
+{
+  return
+    map.is_solid(px, body.y) ||
+    map.is_solid(px, body.y - 31) ||
+    (!body.duck && map.is_solid(px, body.y - 63));
+}
+
+template<typename Map>
+void apply_forces(const Map& map, Body& body, float delta)
+{
+  if (!body_on_ground(map, body))
+    body.vel_y += 10 * delta;
+
+  if (body.jump)
+    body.vel_y = -5;
+}
+
+void apply_steering(Body& body, float delta)
+{
+  switch(body.direction)
+    {
+      case Body::LEFT:
+        if (body.vel_x > -5.0f)
+          body.vel_x -= 10 * delta;
+        break;
+
+      case Body::RIGHT:
+        if (body.vel_x < 5.0f)
+          body.vel_x += 10 * delta;
+        break;
+
+      case Body::NONE:
+        body.vel_x -= body.vel_x * delta * 10.0f;
+        break;
+    }
+}
+
+/** Moves \a body by \a dx until it touches a solid column, returns
+    the fraction of \a dx that was travelled before the impact, or 1.0
+    if there was none */
+template<typename Map>
+float sweep_x(const Map& map, Body& body, float dx)
+{
+  const int shift = map.get_tile_shift();
+  const float tile_size = static_cast<float>(1 << shift);
+
+  if (dx > 0.0f)
+    {
+      const int c0 = to_tile(body.x + 16, shift);
+      const int c1 = to_tile(body.x + 16 + dx, shift);
+      for(int c = c0 + 1; c <= c1; ++c)
+        {
+          const float edge = static_cast<float>(c) * tile_size;
+          if (column_solid(map, body, edge))
+            {
+              const float x = flush_below(edge, 16);
+              const float toi = (x - body.x) / dx;
+              body.x = x;
+              return std::max(0.0f, toi);
+            }
+        }
+    }
+  else if (dx < 0.0f)
+    {
+      const int c0 = to_tile(body.x - 16, shift);
+      const int c1 = to_tile(body.x - 16 + dx, shift);
+      for(int c = c0 - 1; c >= c1; --c)
+        {
+          if (column_solid(map, body, static_cast<float>(c) * tile_size))
+            {
+              const float x = static_cast<float>(c + 1) * tile_size + 16;
+              const float toi = (x - body.x) / dx;
+              body.x = x;
+              return std::max(0.0f, toi);
+            }
+        }
+    }
+
+  body.x += dx;
+  return 1.0f;
+}
+
+/** Vertical counterpart of sweep_x() */
+template<typename Map>
+float sweep_y(const Map& map, Body& body, float dy)
+{
+  const int shift = map.get_tile_shift();
+  const float tile_size = static_cast<float>(1 << shift);
+  const float height = body.duck ? 31.0f : 63.0f;
+
+  if (dy > 0.0f)
+    {
+      const int r0 = to_tile(body.y, shift);
+      const int r1 = to_tile(body.y + dy, shift);
+      for(int r = r0 + 1; r <= r1; ++r)
+        {
+          const float edge = static_cast<float>(r) * tile_size;
+          if (row_solid(map, body.x - 16, body.x + 16, edge))
+            {
+              const float y = flush_below(edge, 0);
+              const float toi = (y - body.y) / dy;
+              body.y = y;
+              return std::max(0.0f, toi);
+            }
+        }
+    }
+  else if (dy < 0.0f)
+    {
+      const int r0 = to_tile(body.y - height, shift);
+      const int r1 = to_tile(body.y - height + dy, shift);
+      for(int r = r0 - 1; r >= r1; --r)
+        {
+          if (row_solid(map, body.x - 16, body.x + 16, static_cast<float>(r) * tile_size))
+            {
+              const float y = static_cast<float>(r + 1) * tile_size + height;
+              const float toi = (y - body.y) / dy;
+              body.y = y;
+              return std::max(0.0f, toi);
+            }
+        }
+    }
+
+  body.y += dy;
+  return 1.0f;
+}
+
+} // namespace
+
+template<typename Map>
+void body_step(const Map& map, Body& body, float delta)
+{
+  apply_forces(map, body, delta);
+
+  float last_x = body.x;
+  float last_y = body.y;
+
+  body.x += body.vel_x;
+
+  if (body_overlaps(map, body))
+    {
+      body.x = last_x;
+      body.vel_x = 0;
+    }
+
+  body.y += body.vel_y;
+  if (body_overlaps(map, body))
+    {
+      body.y = last_y;
+      body.vel_y = 0;
+    }
+
+  apply_steering(body, delta);
+}
+
+template<typename Map>
+StepContacts body_step_swept(const Map& map, Body& body, float delta)
+{
+  StepContacts contacts;
+  contacts.toi_x = 1.0f;
+  contacts.toi_y = 1.0f;
+
+  apply_forces(map, body, delta);
+
+  const float scale = delta / BODY_REFERENCE_STEP;
+
+  if (body_overlaps(map, body))
+    {
+      // already stuck, e.g. after standing up under a ceiling, fall
+      // back to the revert-on-overlap resolution of body_step()
+      float last_x = body.x;
+      body.x += body.vel_x * scale;
+      if (body_overlaps(map, body))
+        {
+          body.x = last_x;
+          body.vel_x = 0;
+          contacts.toi_x = 0.0f;
+        }
+
+      float last_y = body.y;
+      body.y += body.vel_y * scale;
+      if (body_overlaps(map, body))
+        {
+          body.y = last_y;
+          body.vel_y = 0;
+          contacts.toi_y = 0.0f;
+        }
+    }
+  else
+    {
+      contacts.toi_x = sweep_x(map, body, body.vel_x * scale);
+      if (contacts.toi_x < 1.0f)
+        body.vel_x = 0;
+
+      contacts.toi_y = sweep_y(map, body, body.vel_y * scale);
+      if (contacts.toi_y < 1.0f)
+        body.vel_y = 0;
+    }
+
+  apply_steering(body, delta);
+
+  return contacts;
+}
+
+template bool body_overlaps<TileMap>(const TileMap&, const Body&);
+template bool body_on_ground<TileMap>(const TileMap&, const Body&);
+template void body_step<TileMap>(const TileMap&, Body&, float);
+template StepContacts body_step_swept<TileMap>(const TileMap&, Body&, float);
+
+template bool body_overlaps<ChunkedTileMap>(const ChunkedTileMap&, const Body&);
+template bool body_on_ground<ChunkedTileMap>(const ChunkedTileMap&, const Body&);
+template void body_step<ChunkedTileMap>(const ChunkedTileMap&, Body&, float);
+template StepContacts body_step_swept<ChunkedTileMap>(const ChunkedTileMap&, Body&, float);
+
+template bool body_overlaps<SolidMap>(const SolidMap&, const Body&);
+template bool body_on_ground<SolidMap>(const SolidMap&, const Body&);
+template void body_step<SolidMap>(const SolidMap&, Body&, float);
+template StepContacts body_step_swept<SolidMap>(const SolidMap&, Body&, float);
+
+/* EOF */
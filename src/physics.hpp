@@ -0,0 +1,47 @@
+#ifndef HEADER_JNRCOL_PHYSICS_HPP
+#define HEADER_JNRCOL_PHYSICS_HPP
+
+class Body;
+
+/** The timestep the velocities of a Body are expressed in, body_step()
+    moves a body by its velocity each step regardless of the timestep,
+    body_step_swept() scales the movement by delta / BODY_REFERENCE_STEP */
+const float BODY_REFERENCE_STEP = 0.01f;
+
+/** Result of body_step_swept(), the time of impact along each axis as
+    a fraction of the step's movement, 1.0 if there was no contact */
+struct StepContacts
+{
+  float toi_x;
+  float toi_y;
+};
+
+/* The functions below work on any map type providing is_solid(float,
+   float), they are explicitly instantiated for TileMap, ChunkedTileMap
+   and SolidMap in physics.cpp. */
+
+/** Returns true if \a body overlaps any solid tile */
+template<typename Map>
+bool body_overlaps(const Map& map, const Body& body);
+
+/** Returns true if \a body is resting on a solid tile */
+template<typename Map>
+bool body_on_ground(const Map& map, const Body& body);
+
+/** Advances \a body by one physics step of \a delta seconds, on
+    contact the movement along that axis is reverted, so small steps
+    are needed to avoid stopping short of walls or tunnelling */
+template<typename Map>
+void body_step(const Map& map, Body& body, float delta);
+
+/** Advances \a body by one physics step of \a delta seconds, sweeping
+    the box along each axis through the tile grid and stopping it flush
+    against the first solid tile, the other axis still moves, so the
+    body slides along walls, floors and ceilings. Unlike body_step()
+    this stays accurate with large timesteps. */
+template<typename Map>
+StepContacts body_step_swept(const Map& map, Body& body, float delta);
+
+#endif
+
+/* EOF */
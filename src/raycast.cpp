@@ -0,0 +1,110 @@
+#include "raycast.hpp"
+
+#include <cmath>
+#include <limits>
+
+#include "solid_map.hpp"
+
+namespace {
+
+inline bool raycast_impl(const SolidMap& map, const Ray& ray, RayHit& hit)
+{
+  const int shift = map.get_tile_shift();
+  const float tile_size = static_cast<float>(1 << shift);
+  const float inf = std::numeric_limits<float>::infinity();
+
+  int tx = static_cast<int>(std::floor(ray.x)) >> shift;
+  int ty = static_cast<int>(std::floor(ray.y)) >> shift;
+
+  hit.hit = false;
+  hit.normal_x = 0;
+  hit.normal_y = 0;
+
+  const int step_x = ray.dx > 0.0f ? 1 : (ray.dx < 0.0f ? -1 : 0);
+  const int step_y = ray.dy > 0.0f ? 1 : (ray.dy < 0.0f ? -1 : 0);
+
+  // ray parameter at which the next column/row boundary is crossed,
+  // computed from the boundary position each time instead of being
+  // accumulated, so long rays don't drift
+  const float inv_dx = step_x != 0 ? 1.0f / ray.dx : 0.0f;
+  const float inv_dy = step_y != 0 ? 1.0f / ray.dy : 0.0f;
+  const int next_x = step_x > 0 ? 1 : 0;
+  const int next_y = step_y > 0 ? 1 : 0;
+
+  float t_max_x = step_x != 0 ? (static_cast<float>(tx + next_x) * tile_size - ray.x) * inv_dx : inf;
+  float t_max_y = step_y != 0 ? (static_cast<float>(ty + next_y) * tile_size - ray.y) * inv_dy : inf;
+
+  float t = 0.0f;
+  while(true)
+    {
+      if (map.is_solid_tile(tx, ty))
+        {
+          hit.hit = true;
+          hit.tile_x = tx;
+          hit.tile_y = ty;
+          hit.t = t;
+          hit.x = ray.x + t * ray.dx;
+          hit.y = ray.y + t * ray.dy;
+          return true;
+        }
+
+      if (t_max_x < t_max_y)
+        {
+          t = t_max_x;
+          tx += step_x;
+          t_max_x = (static_cast<float>(tx + next_x) * tile_size - ray.x) * inv_dx;
+          hit.normal_x = -step_x;
+          hit.normal_y = 0;
+        }
+      else
+        {
+          t = t_max_y;
+          ty += step_y;
+          t_max_y = (static_cast<float>(ty + next_y) * tile_size - ray.y) * inv_dy;
+          hit.normal_x = 0;
+          hit.normal_y = -step_y;
+        }
+
+      // a point on a boundary belongs to the right/lower tile, so when
+      // moving left or up the next tile is only entered after the
+      // boundary, the zero length ray ends here as well
+      const bool backwards = hit.normal_x > 0 || hit.normal_y > 0;
+      if (t > ray.max_t || (backwards && t == ray.max_t) || (step_x == 0 && step_y == 0))
+        {
+          hit.normal_x = 0;
+          hit.normal_y = 0;
+          return false;
+        }
+    }
+}
+
+} // namespace
+
+bool raycast(const SolidMap& map, const Ray& ray, RayHit& hit)
+{
+  return raycast_impl(map, ray, hit);
+}
+
+bool segment_cast(const SolidMap& map, float x0, float y0, float x1, float y1, RayHit& hit)
+{
+  const Ray ray = { x0, y0, x1 - x0, y1 - y0, 1.0f };
+  return raycast_impl(map, ray, hit);
+}
+
+bool line_of_sight(const SolidMap& map, float x0, float y0, float x1, float y1)
+{
+  RayHit hit;
+  return !segment_cast(map, x0, y0, x1, y1, hit);
+}
+
+size_t raycast_batch(const SolidMap& map, const Ray* rays, size_t count, RayHit* hits)
+{
+  size_t num_hits = 0;
+  for(size_t i = 0; i < count; ++i)
+    {
+      num_hits += raycast_impl(map, rays[i], hits[i]);
+    }
+  return num_hits;
+}
+
+/* EOF */
@@ -0,0 +1,55 @@
+#ifndef HEADER_JNRCOL_RAYCAST_HPP
+#define HEADER_JNRCOL_RAYCAST_HPP
+
+#include <cstddef>
+
+class SolidMap;
+
+/** A ray from (x, y) along (dx, dy), points on the ray are
+    (x + t * dx, y + t * dy) for t in [0, max_t] */
+struct Ray
+{
+  float x;
+  float y;
+  float dx;
+  float dy;
+  float max_t;
+};
+
+struct RayHit
+{
+  bool hit;
+
+  /** The solid tile that was hit */
+  int tile_x;
+  int tile_y;
+
+  /** The point where the ray enters the tile and its ray parameter */
+  float x;
+  float y;
+  float t;
+
+  /** The side of the tile that was hit, (0, 0) if the ray started
+      inside a solid tile */
+  int normal_x;
+  int normal_y;
+};
+
+/** Walks the tiles along \a ray (Amanatides & Woo) and reports the
+    first solid one in \a hit, returns true if one was found before
+    max_t. As everywhere else, the area outside of the map is solid. */
+bool raycast(const SolidMap& map, const Ray& ray, RayHit& hit);
+
+/** Casts from (x0, y0) to (x1, y1) */
+bool segment_cast(const SolidMap& map, float x0, float y0, float x1, float y1, RayHit& hit);
+
+/** Returns true if no solid tile lies between the two points */
+bool line_of_sight(const SolidMap& map, float x0, float y0, float x1, float y1);
+
+/** Casts \a count rays at once, results are written to \a hits, returns
+    the number of rays that hit something */
+size_t raycast_batch(const SolidMap& map, const Ray* rays, size_t count, RayHit* hits);
+
+#endif
+
+/* EOF */
@@ -0,0 +1,60 @@
+#include "sim_clock.hpp"
+
+SimClock::SimClock(uint32_t step_ms, uint32_t max_steps) :
+  m_step_ms(step_ms),
+  m_max_steps(max_steps),
+  m_last_tick(0),
+  m_accumulator(0),
+  m_dropped_steps(0),
+  m_started(false)
+{
+}
+
+void
+SimClock::reset(uint32_t tick)
+{
+  m_last_tick = tick;
+  m_accumulator = 0;
+  m_started = true;
+}
+
+uint32_t
+SimClock::advance(uint32_t tick)
+{
+  if (!m_started)
+    {
+      reset(tick);
+      return 0;
+    }
+
+  // unsigned subtraction, stays correct when the tick counter wraps
+  m_accumulator += tick - m_last_tick;
+  m_last_tick = tick;
+
+  uint32_t steps = m_accumulator / m_step_ms;
+  m_accumulator -= steps * m_step_ms;
+
+  if (steps > m_max_steps)
+    {
+      m_dropped_steps += steps - m_max_steps;
+      steps = m_max_steps;
+    }
+
+  return steps;
+}
+
+float
+SimClock::get_alpha() const
+{
+  return static_cast<float>(m_accumulator) / static_cast<float>(m_step_ms);
+}
+
+Body interpolate_body(const Body& prev, const Body& next, float alpha)
+{
+  Body body = next;
+  body.x = prev.x + (next.x - prev.x) * alpha;
+  body.y = prev.y + (next.y - prev.y) * alpha;
+  return body;
+}
+
+/* EOF */
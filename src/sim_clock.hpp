@@ -0,0 +1,56 @@
+#ifndef HEADER_JNRCOL_SIM_CLOCK_HPP
+#define HEADER_JNRCOL_SIM_CLOCK_HPP
+
+#include <cstdint>
+
+#include "body.hpp"
+
+/** Turns wall clock time into a whole number of fixed physics steps.
+    Time that does not fill a whole step is carried over to the next
+    frame and used to interpolate between the last two physics states.
+    After a stall at most \a max_steps are run per frame and the rest
+    of the backlog is dropped, so a slow frame can't cause even more
+    work in the next one. Time is kept in integer milliseconds, so no
+    rounding error accumulates. */
+class SimClock
+{
+private:
+  uint32_t m_step_ms;
+  uint32_t m_max_steps;
+  uint32_t m_last_tick;
+  uint32_t m_accumulator;
+  uint64_t m_dropped_steps;
+  bool m_started;
+
+public:
+  SimClock(uint32_t step_ms = 10, uint32_t max_steps = 10);
+
+  /** Starts measuring from \a tick, e.g. SDL_GetTicks(), without
+      running any steps for the time before it */
+  void reset(uint32_t tick);
+
+  /** Returns the number of physics steps to run for the time between
+      the last call and \a tick, the first call only starts the clock */
+  uint32_t advance(uint32_t tick);
+
+  /** Fraction of a step that is left over, 0.0 means the current
+      physics state is exactly on time, use it as the weight of the
+      current state when interpolating */
+  float get_alpha() const;
+
+  uint32_t get_step_ms() const { return m_step_ms; }
+  uint32_t get_max_steps() const { return m_max_steps; }
+
+  /** Number of steps that were skipped because a frame exceeded the
+      catch-up budget */
+  uint64_t get_dropped_steps() const { return m_dropped_steps; }
+};
+
+/** Returns the state between \a prev and \a next, for rendering a body
+    between two physics steps, everything but the position is taken
+    from \a next */
+Body interpolate_body(const Body& prev, const Body& next, float alpha);
+
+#endif
+
+/* EOF */
@@ -0,0 +1,44 @@
+#include "solid_map.hpp"
+
+#include "tilemap.hpp"
+
+SolidMap::SolidMap(const TileMap& map) :
+  m_words(),
+  m_width(map.get_width()),
+  m_height(map.get_height()),
+  m_words_per_row((map.get_width() + 63) / 64),
+  m_tile_shift(map.get_tile_shift()),
+  m_width_px(static_cast<unsigned int>(map.get_width()) << map.get_tile_shift()),
+  m_height_px(static_cast<unsigned int>(map.get_height()) << map.get_tile_shift())
+{
+  m_words.resize(static_cast<size_t>(m_words_per_row) * static_cast<size_t>(m_height), 0);
+
+  for(int y = 0; y < m_height; ++y)
+    {
+      const char* row = map.get_data() + static_cast<size_t>(y) * static_cast<size_t>(m_width);
+      uint64_t* words = m_words.data() + static_cast<size_t>(y) * static_cast<size_t>(m_words_per_row);
+      for(int x = 0; x < m_width; ++x)
+        {
+          if (row[x] != ' ')
+            words[x >> 6] |= uint64_t(1) << (x & 63);
+        }
+    }
+}
+
+bool
+SolidMap::is_multiword_span_solid(const uint64_t* row, int w0, int w1,
+                                  uint64_t first_mask, uint64_t last_mask)
+{
+  if (row[w0] & first_mask)
+    return true;
+
+  for(int w = w0 + 1; w < w1; ++w)
+    {
+      if (row[w])
+        return true;
+    }
+
+  return (row[w1] & last_mask) != 0;
+}
+
+/* EOF */
@@ -0,0 +1,115 @@
+#ifndef HEADER_JNRCOL_SOLID_MAP_HPP
+#define HEADER_JNRCOL_SOLID_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class TileMap;
+
+/** One bit per tile solidity layer derived from a TileMap, a bit is set
+    for every tile that is not ' '. Rows are padded to a multiple of 64
+    bits so that spans of a row can be tested a word at a time. As with
+    TileMap everything outside of the map is solid. */
+class SolidMap
+{
+private:
+  std::vector<uint64_t> m_words;
+  int m_width;
+  int m_height;
+  int m_words_per_row;
+  int m_tile_shift;
+  unsigned int m_width_px;
+  unsigned int m_height_px;
+
+public:
+  explicit SolidMap(const TileMap& map);
+
+  int get_width() const { return m_width; }
+  int get_height() const { return m_height; }
+  int get_tile_shift() const { return m_tile_shift; }
+  int get_tile_size() const { return 1 << m_tile_shift; }
+
+  /** Map size in pixels */
+  unsigned int get_width_px() const { return m_width_px; }
+  unsigned int get_height_px() const { return m_height_px; }
+
+  int get_words_per_row() const { return m_words_per_row; }
+  const uint64_t* get_words() const { return m_words.data(); }
+
+  /** Returns true if the tile at tile coordinates \a tx, \a ty is solid */
+  bool is_solid_tile(int tx, int ty) const
+  {
+    if ((static_cast<unsigned int>(tx) >= static_cast<unsigned int>(m_width)) |
+        (static_cast<unsigned int>(ty) >= static_cast<unsigned int>(m_height)))
+      return true;
+    else
+      return (m_words[static_cast<size_t>(ty) * static_cast<size_t>(m_words_per_row) +
+                      static_cast<size_t>(tx >> 6)] >> (tx & 63)) & 1;
+  }
+
+  /** Returns true if the tile at integer pixel position \a px, \a py is solid */
+  bool is_solid_px(int px, int py) const
+  {
+    if ((static_cast<unsigned int>(px) >= m_width_px) |
+        (static_cast<unsigned int>(py) >= m_height_px))
+      return true;
+    else
+      return is_solid_tile(px >> m_tile_shift, py >> m_tile_shift);
+  }
+
+  /** Returns true if the tile at pixel position \a x, \a y is solid */
+  bool is_solid(float x, float y) const
+  {
+    // reject out of range and NaN positions before the int conversion
+    if (!(x >= 0.0f && x < static_cast<float>(m_width_px) &&
+          y >= 0.0f && y < static_cast<float>(m_height_px)))
+      return true;
+    else
+      return is_solid_px(static_cast<int>(x), static_cast<int>(y));
+  }
+
+  /** Returns true if any of the tiles \a tx0 to \a tx1 (inclusive) in
+      row \a ty is solid */
+  bool is_span_solid_tile(int ty, int tx0, int tx1) const
+  {
+    if (tx0 < 0 || tx1 >= m_width ||
+        static_cast<unsigned int>(ty) >= static_cast<unsigned int>(m_height))
+      return true;
+
+    const uint64_t* row = m_words.data() + static_cast<size_t>(ty) * static_cast<size_t>(m_words_per_row);
+    const int w0 = tx0 >> 6;
+    const int w1 = tx1 >> 6;
+    const uint64_t first_mask = ~uint64_t(0) << (tx0 & 63);
+    const uint64_t last_mask = ~uint64_t(0) >> (63 - (tx1 & 63));
+
+    if (w0 == w1)
+      return (row[w0] & first_mask & last_mask) != 0;
+    else
+      return is_multiword_span_solid(row, w0, w1, first_mask, last_mask);
+  }
+
+  /** Returns true if any tile in the row at pixel height \a y between
+      pixel positions \a left and \a right (inclusive) is solid */
+  bool is_span_solid(float left, float right, float y) const
+  {
+    // reject out of range and NaN positions before the int conversion
+    if (!(left >= 0.0f && left < static_cast<float>(m_width_px) &&
+          right >= 0.0f && right < static_cast<float>(m_width_px) &&
+          y >= 0.0f && y < static_cast<float>(m_height_px)))
+      return true;
+
+    const int px0 = static_cast<int>(left);
+    const int px1 = static_cast<int>(right);
+    const int py = static_cast<int>(y);
+    return is_span_solid_tile(py >> m_tile_shift, px0 >> m_tile_shift, px1 >> m_tile_shift);
+  }
+
+private:
+  static bool is_multiword_span_solid(const uint64_t* row, int w0, int w1,
+                                      uint64_t first_mask, uint64_t last_mask);
+};
+
+#endif
+
+/* EOF */
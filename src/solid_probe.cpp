@@ -0,0 +1,201 @@
+#include "solid_probe.hpp"
+
+#include "solid_map.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#  define JNRCOL_PROBE_X86 1
+#  include <immintrin.h>
+#endif
+
+void solid_probe_batch_scalar(const SolidMap& map, const float* xs, const float* ys, size_t count, uint8_t* out)
+{
+  for(size_t i = 0; i < count; ++i)
+    {
+      out[i] = map.is_solid(xs[i], ys[i]) ? 1 : 0;
+    }
+}
+
+#ifdef JNRCOL_PROBE_X86
+
+namespace {
+
+/** Low 32 bits of the lane-wise product, SSE2 only has _mm_mul_epu32()
+    for the even lanes */
+inline __m128i mullo_epi32_sse2(__m128i a, __m128i b)
+{
+  const __m128i even = _mm_mul_epu32(a, b);
+  const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+} // namespace
+
+void solid_probe_batch_sse2(const SolidMap& map, const float* xs, const float* ys, size_t count, uint8_t* out)
+{
+  // the rows are little-endian 64 bit words, so they can be addressed
+  // bytewise with bit (tx & 7) of byte (tx >> 3)
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(map.get_words());
+  const __m128i row_bytes = _mm_set1_epi32(map.get_words_per_row() * 8);
+  const __m128i shift = _mm_cvtsi32_si128(map.get_tile_shift());
+
+  // unsigned compares are done as signed ones with the sign bit flipped
+  const __m128i sign = _mm_set1_epi32(static_cast<int>(0x80000000u));
+  const __m128i max_x = _mm_set1_epi32(static_cast<int>((map.get_width_px() - 1) ^ 0x80000000u));
+  const __m128i max_y = _mm_set1_epi32(static_cast<int>((map.get_height_px() - 1) ^ 0x80000000u));
+
+  const __m128 zero = _mm_setzero_ps();
+  const __m128i low3 = _mm_set1_epi32(7);
+
+  size_t i = 0;
+  for(; i + 4 <= count; i += 4)
+    {
+      const __m128 x = _mm_loadu_ps(xs + i);
+      const __m128 y = _mm_loadu_ps(ys + i);
+
+      const __m128i px = _mm_cvttps_epi32(x);
+      const __m128i py = _mm_cvttps_epi32(y);
+
+      const __m128i outside =
+        _mm_or_si128(_mm_or_si128(_mm_castps_si128(_mm_cmplt_ps(x, zero)),
+                                  _mm_castps_si128(_mm_cmplt_ps(y, zero))),
+                     _mm_or_si128(_mm_cmpgt_epi32(_mm_xor_si128(px, sign), max_x),
+                                  _mm_cmpgt_epi32(_mm_xor_si128(py, sign), max_y)));
+
+      const __m128i tx = _mm_srl_epi32(px, shift);
+      const __m128i ty = _mm_srl_epi32(py, shift);
+
+      // lanes outside of the map load byte 0 and are forced to solid
+      // below, so the loads need no branches
+      const __m128i index = _mm_andnot_si128(outside, _mm_add_epi32(mullo_epi32_sse2(ty, row_bytes),
+                                                                    _mm_srli_epi32(tx, 3)));
+
+      alignas(16) uint32_t idx[4];
+      alignas(16) uint32_t bit[4];
+      _mm_store_si128(reinterpret_cast<__m128i*>(idx), index);
+      _mm_store_si128(reinterpret_cast<__m128i*>(bit), _mm_and_si128(tx, low3));
+      const int solid = _mm_movemask_ps(_mm_castsi128_ps(outside));
+
+      for(int k = 0; k < 4; ++k)
+        {
+          out[i + k] = static_cast<uint8_t>(((bytes[idx[k]] >> bit[k]) & 1) | ((solid >> k) & 1));
+        }
+    }
+
+  solid_probe_batch_scalar(map, xs + i, ys + i, count - i, out + i);
+}
+
+__attribute__((target("avx2")))
+void solid_probe_batch_avx2(const SolidMap& map, const float* xs, const float* ys, size_t count, uint8_t* out)
+{
+  // gathers are done on 32 bit words, bit (tx & 31) of word (tx >> 5)
+  const int* words = reinterpret_cast<const int*>(map.get_words());
+  const __m256i words_per_row = _mm256_set1_epi32(map.get_words_per_row() * 2);
+  const __m128i shift = _mm_cvtsi32_si128(map.get_tile_shift());
+
+  // unsigned compares are done as signed ones with the sign bit flipped
+  const __m256i sign = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+  const __m256i max_x = _mm256_set1_epi32(static_cast<int>((map.get_width_px() - 1) ^ 0x80000000u));
+  const __m256i max_y = _mm256_set1_epi32(static_cast<int>((map.get_height_px() - 1) ^ 0x80000000u));
+
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256i ones = _mm256_set1_epi32(-1);
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i low5 = _mm256_set1_epi32(31);
+
+  size_t i = 0;
+  for(; i + 8 <= count; i += 8)
+    {
+      const __m256 x = _mm256_loadu_ps(xs + i);
+      const __m256 y = _mm256_loadu_ps(ys + i);
+
+      const __m256i px = _mm256_cvttps_epi32(x);
+      const __m256i py = _mm256_cvttps_epi32(y);
+
+      const __m256i outside =
+        _mm256_or_si256(_mm256_or_si256(_mm256_castps_si256(_mm256_cmp_ps(x, zero, _CMP_LT_OQ)),
+                                        _mm256_castps_si256(_mm256_cmp_ps(y, zero, _CMP_LT_OQ))),
+                        _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_xor_si256(px, sign), max_x),
+                                        _mm256_cmpgt_epi32(_mm256_xor_si256(py, sign), max_y)));
+
+      const __m256i tx = _mm256_srl_epi32(px, shift);
+      const __m256i ty = _mm256_srl_epi32(py, shift);
+      const __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(ty, words_per_row),
+                                             _mm256_srli_epi32(tx, 5));
+
+      // lanes outside of the map are not loaded and keep all bits set,
+      // i.e. they are solid
+      const __m256i word = _mm256_mask_i32gather_epi32(ones, words, index,
+                                                       _mm256_xor_si256(outside, ones), 4);
+      const __m256i bit = _mm256_and_si256(_mm256_srlv_epi32(word, _mm256_and_si256(tx, low5)), one);
+
+      const __m128i bit16 = _mm_packs_epi32(_mm256_castsi256_si128(bit), _mm256_extracti128_si256(bit, 1));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(bit16, bit16));
+    }
+
+  solid_probe_batch_scalar(map, xs + i, ys + i, count - i, out + i);
+}
+
+bool solid_probe_has_avx2()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+void solid_probe_batch_sse2(const SolidMap& map, const float* xs, const float* ys, size_t count, uint8_t* out)
+{
+  solid_probe_batch_scalar(map, xs, ys, count, out);
+}
+
+void solid_probe_batch_avx2(const SolidMap& map, const float* xs, const float* ys, size_t count, uint8_t* out)
+{
+  solid_probe_batch_scalar(map, xs, ys, count, out);
+}
+
+bool solid_probe_has_avx2()
+{
+  return false;
+}
+
+#endif
+
+namespace {
+
+typedef void (*ProbeFunc)(const SolidMap&, const float*, const float*, size_t, uint8_t*);
+
+struct ProbeImpl
+{
+  ProbeFunc func;
+  const char* name;
+};
+
+const ProbeImpl& select_impl()
+{
+  static const ProbeImpl impl = []() -> ProbeImpl {
+#ifdef JNRCOL_PROBE_X86
+    if (solid_probe_has_avx2())
+      return ProbeImpl{ solid_probe_batch_avx2, "avx2" };
+    else
+      return ProbeImpl{ solid_probe_batch_sse2, "sse2" };
+#else
+    return ProbeImpl{ solid_probe_batch_scalar, "scalar" };
+#endif
+  }();
+  return impl;
+}
+
+} // namespace
+
+void solid_probe_batch(const SolidMap& map, const float* xs, const float* ys, size_t count, uint8_t* out)
+{
+  select_impl().func(map, xs, ys, count, out);
+}
+
+const char* solid_probe_impl_name()
+{
+  return select_impl().name;
+}
+
+/* EOF */
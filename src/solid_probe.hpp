@@ -0,0 +1,32 @@
+#ifndef HEADER_JNRCOL_SOLID_PROBE_HPP
+#define HEADER_JNRCOL_SOLID_PROBE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+class SolidMap;
+
+/* Batched point probes against a SolidMap. out[i] is set to 1 if the
+   point (xs[i], ys[i]) is solid and to 0 otherwise, with exactly the
+   same result as SolidMap::is_solid(). */
+
+/** Probes \a count points using the fastest implementation the CPU
+    supports, selected on first use */
+void solid_probe_batch(const SolidMap& map, const float* xs, const float* ys, size_t count, uint8_t* out);
+
+/** Returns the name of the implementation used by solid_probe_batch() */
+const char* solid_probe_impl_name();
+
+/* The individual implementations, mainly for benchmarking. The SSE2 and
+   AVX2 variants fall back to the scalar one when they are not compiled
+   in, the AVX2 one must only be called if the CPU supports it. */
+void solid_probe_batch_scalar(const SolidMap& map, const float* xs, const float* ys, size_t count, uint8_t* out);
+void solid_probe_batch_sse2(const SolidMap& map, const float* xs, const float* ys, size_t count, uint8_t* out);
+void solid_probe_batch_avx2(const SolidMap& map, const float* xs, const float* ys, size_t count, uint8_t* out);
+
+/** Returns true if solid_probe_batch_avx2() can be used on this CPU */
+bool solid_probe_has_avx2();
+
+#endif
+
+/* EOF */
@@ -0,0 +1,138 @@
+#include "spatial_hash.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "world.hpp"
+
+namespace {
+
+int32_t to_cell(float v, int shift)
+{
+  return static_cast<int32_t>(std::floor(v)) >> shift;
+}
+
+} // namespace
+
+SpatialHash::SpatialHash(int cell_shift) :
+  m_cell_shift(cell_shift),
+  m_table_mask(0),
+  m_boxes(),
+  m_ranges(),
+  m_bucket_start(),
+  m_entries()
+{
+}
+
+void
+SpatialHash::rebuild(const World& world)
+{
+  m_boxes.resize(world.size());
+  const float* xs = world.get_x();
+  const float* ys = world.get_y();
+  const uint8_t* flags = world.get_flags();
+  for(size_t i = 0; i < world.size(); ++i)
+    {
+      m_boxes[i] = body_aabb(xs[i], ys[i], (flags[i] & World::FLAG_DUCK) != 0);
+    }
+  build_grid();
+}
+
+void
+SpatialHash::rebuild(const Aabb* boxes, size_t count)
+{
+  m_boxes.assign(boxes, boxes + count);
+  build_grid();
+}
+
+void
+SpatialHash::build_grid()
+{
+  const std::vector<Aabb>& boxes = m_boxes;
+  const size_t count = boxes.size();
+  m_ranges.resize(count);
+
+  size_t num_entries = 0;
+  for(size_t i = 0; i < count; ++i)
+    {
+      CellRange& range = m_ranges[i];
+      range.cx0 = to_cell(boxes[i].left, m_cell_shift);
+      range.cy0 = to_cell(boxes[i].top, m_cell_shift);
+      range.cx1 = to_cell(boxes[i].right, m_cell_shift);
+      range.cy1 = to_cell(boxes[i].bottom, m_cell_shift);
+      num_entries += static_cast<size_t>(range.cx1 - range.cx0 + 1) * static_cast<size_t>(range.cy1 - range.cy0 + 1);
+    }
+
+  // keep the table at least twice as large as the number of entries
+  size_t table_size = 64;
+  while(table_size < num_entries * 2)
+    table_size *= 2;
+  m_table_mask = table_size - 1;
+
+  // counting sort of the entries by bucket
+  m_bucket_start.assign(table_size + 1, 0);
+  for(const auto& range : m_ranges)
+    for(int32_t cy = range.cy0; cy <= range.cy1; ++cy)
+      for(int32_t cx = range.cx0; cx <= range.cx1; ++cx)
+        m_bucket_start[bucket(cx, cy) + 1] += 1;
+
+  for(size_t b = 0; b < table_size; ++b)
+    m_bucket_start[b + 1] += m_bucket_start[b];
+
+  std::vector<uint32_t> fill(m_bucket_start.begin(), m_bucket_start.end() - 1);
+  m_entries.resize(num_entries);
+  for(size_t i = 0; i < count; ++i)
+    {
+      const CellRange& range = m_ranges[i];
+      for(int32_t cy = range.cy0; cy <= range.cy1; ++cy)
+        for(int32_t cx = range.cx0; cx <= range.cx1; ++cx)
+          m_entries[fill[bucket(cx, cy)]++] = Entry{ cx, cy, static_cast<uint32_t>(i) };
+    }
+}
+
+template<bool narrowphase>
+void
+SpatialHash::collect(std::vector<BodyPair>& pairs) const
+{
+  for(size_t i = 0; i < m_ranges.size(); ++i)
+    {
+      const CellRange& range = m_ranges[i];
+      for(int32_t cy = range.cy0; cy <= range.cy1; ++cy)
+        for(int32_t cx = range.cx0; cx <= range.cx1; ++cx)
+          {
+            const size_t b = bucket(cx, cy);
+            for(uint32_t e = m_bucket_start[b]; e < m_bucket_start[b + 1]; ++e)
+              {
+                const Entry& entry = m_entries[e];
+                if (entry.index <= i || entry.cx != cx || entry.cy != cy)
+                  continue;
+
+                // two bodies can share several cells, only report the
+                // pair in the top left one of the shared cells
+                const CellRange& other = m_ranges[entry.index];
+                if (std::max(range.cx0, other.cx0) != cx ||
+                    std::max(range.cy0, other.cy0) != cy)
+                  continue;
+
+                if (narrowphase && !aabb_overlap(m_boxes[i], m_boxes[entry.index]))
+                  continue;
+
+                pairs.push_back(BodyPair{ static_cast<uint32_t>(i), entry.index });
+              }
+          }
+    }
+}
+
+void
+SpatialHash::find_candidates(std::vector<BodyPair>& pairs) const
+{
+  collect<false>(pairs);
+}
+
+void
+SpatialHash::find_overlaps(std::vector<BodyPair>& pairs) const
+{
+  collect<true>(pairs);
+}
+
+/* EOF */
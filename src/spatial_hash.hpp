@@ -0,0 +1,103 @@
+#ifndef HEADER_JNRCOL_SPATIAL_HASH_HPP
+#define HEADER_JNRCOL_SPATIAL_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class World;
+
+/** Axis aligned box, all edges are inclusive like the tile probes */
+struct Aabb
+{
+  float left;
+  float top;
+  float right;
+  float bottom;
+};
+
+/** Returns the box tested by body_overlaps() for a body at \a x, \a y */
+inline Aabb body_aabb(float x, float y, bool duck)
+{
+  return Aabb{ x - 16, y - (duck ? 31.0f : 63.0f), x + 16, y };
+}
+
+inline bool aabb_overlap(const Aabb& a, const Aabb& b)
+{
+  return
+    a.left <= b.right && b.left <= a.right &&
+    a.top <= b.bottom && b.top <= a.bottom;
+}
+
+/** A pair of body indices, a < b */
+struct BodyPair
+{
+  uint32_t a;
+  uint32_t b;
+};
+
+/** Uniform grid broadphase for body-vs-body collision. Bodies are
+    inserted into every cell their box touches, the cells use the tile
+    size by default, and are hashed into a table that is rebuilt from
+    scratch with a counting sort each step, so the memory layout stays
+    compact regardless of how far the bodies are spread. */
+class SpatialHash
+{
+private:
+  struct Entry
+  {
+    int32_t cx;
+    int32_t cy;
+    uint32_t index;
+  };
+
+  struct CellRange
+  {
+    int32_t cx0;
+    int32_t cy0;
+    int32_t cx1;
+    int32_t cy1;
+  };
+
+  int m_cell_shift;
+  size_t m_table_mask;
+  std::vector<Aabb> m_boxes;
+  std::vector<CellRange> m_ranges;
+  std::vector<uint32_t> m_bucket_start;
+  std::vector<Entry> m_entries;
+
+public:
+  explicit SpatialHash(int cell_shift = 5);
+
+  /** Rebuilds the grid from the positions and duck flags of \a world */
+  void rebuild(const World& world);
+
+  /** Rebuilds the grid from \a count boxes */
+  void rebuild(const Aabb* boxes, size_t count);
+
+  size_t size() const { return m_boxes.size(); }
+  const Aabb& get_box(size_t i) const { return m_boxes[i]; }
+
+  /** Appends every pair of bodies that share at least one cell to
+      \a pairs, each pair is reported once */
+  void find_candidates(std::vector<BodyPair>& pairs) const;
+
+  /** Like find_candidates(), but only keeps pairs whose boxes overlap */
+  void find_overlaps(std::vector<BodyPair>& pairs) const;
+
+private:
+  size_t bucket(int32_t cx, int32_t cy) const
+  {
+    const uint32_t h = (static_cast<uint32_t>(cx) * 73856093u) ^ (static_cast<uint32_t>(cy) * 19349663u);
+    return static_cast<size_t>(h) & m_table_mask;
+  }
+
+  void build_grid();
+
+  template<bool narrowphase>
+  void collect(std::vector<BodyPair>& pairs) const;
+};
+
+#endif
+
+/* EOF */
@@ -0,0 +1,72 @@
+#include "tilemap.hpp"
+
+#include <algorithm>
+
+TileMap
+TileMap::from_rows(const char* const* rows, int width, int height, int tile_shift)
+{
+  TileMap map(width, height, ' ', tile_shift);
+  for(int y = 0; y < height; ++y)
+    {
+      std::copy(rows[y], rows[y] + width,
+                map.m_storage.begin() + static_cast<std::ptrdiff_t>(y) * width);
+    }
+  return map;
+}
+
+TileMap
+TileMap::from_memory(std::shared_ptr<const void> owner, const char* tiles,
+                     int width, int height, int tile_shift)
+{
+  TileMap map(0, 0, ' ', tile_shift);
+  map.m_owner = std::move(owner);
+  map.m_tiles = tiles;
+  map.m_width = width;
+  map.m_height = height;
+  map.m_width_px = static_cast<unsigned int>(width) << tile_shift;
+  map.m_height_px = static_cast<unsigned int>(height) << tile_shift;
+  return map;
+}
+
+TileMap::TileMap(int width, int height, char fill, int tile_shift) :
+  m_storage(static_cast<size_t>(width) * static_cast<size_t>(height), fill),
+  m_owner(),
+  m_tiles(m_storage.data()),
+  m_width(width),
+  m_height(height),
+  m_tile_shift(tile_shift),
+  m_width_px(static_cast<unsigned int>(width) << tile_shift),
+  m_height_px(static_cast<unsigned int>(height) << tile_shift)
+{
+}
+
+TileMap::TileMap(const TileMap& other) :
+  m_storage(other.m_storage),
+  m_owner(other.m_owner),
+  m_tiles(other.m_owner ? other.m_tiles : m_storage.data()),
+  m_width(other.m_width),
+  m_height(other.m_height),
+  m_tile_shift(other.m_tile_shift),
+  m_width_px(other.m_width_px),
+  m_height_px(other.m_height_px)
+{
+}
+
+TileMap&
+TileMap::operator=(const TileMap& other)
+{
+  if (this != &other)
+    {
+      m_storage = other.m_storage;
+      m_owner = other.m_owner;
+      m_tiles = m_owner ? other.m_tiles : m_storage.data();
+      m_width = other.m_width;
+      m_height = other.m_height;
+      m_tile_shift = other.m_tile_shift;
+      m_width_px = other.m_width_px;
+      m_height_px = other.m_height_px;
+    }
+  return *this;
+}
+
+/* EOF */
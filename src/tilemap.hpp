@@ -0,0 +1,106 @@
+#ifndef HEADER_JNRCOL_TILEMAP_HPP
+#define HEADER_JNRCOL_TILEMAP_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/** A grid of tiles, ' ' is empty space, everything else is solid.
+    Positions outside of the map are reported as 'X'. The tiles are
+    stored as one contiguous row-major buffer, either owned by the map
+    or borrowed from memory kept alive by a shared owner (e.g. a
+    mmap()ed level file). Tiles are square with a power of two size, so
+    pixel to tile conversion is a shift. */
+class TileMap
+{
+public:
+  /** Creates a map from \a height strings of at least \a width characters */
+  static TileMap from_rows(const char* const* rows, int width, int height, int tile_shift = 5);
+
+  /** Creates a read-only map that uses \a tiles directly, \a owner
+      keeps the memory alive for as long as the map or any copy of it
+      exists */
+  static TileMap from_memory(std::shared_ptr<const void> owner, const char* tiles,
+                             int width, int height, int tile_shift = 5);
+
+private:
+  std::vector<char> m_storage;
+  std::shared_ptr<const void> m_owner;
+  const char* m_tiles;
+  int m_width;
+  int m_height;
+  int m_tile_shift;
+
+  /** Map size in pixels, unsigned so that negative coordinates fail
+      the same comparison as too large ones */
+  unsigned int m_width_px;
+  unsigned int m_height_px;
+
+public:
+  TileMap(int width, int height, char fill = ' ', int tile_shift = 5);
+  TileMap(const TileMap& other);
+  TileMap(TileMap&& other) = default;
+
+  TileMap& operator=(const TileMap& other);
+  TileMap& operator=(TileMap&& other) = default;
+
+  int get_width() const { return m_width; }
+  int get_height() const { return m_height; }
+  int get_tile_shift() const { return m_tile_shift; }
+  int get_tile_size() const { return 1 << m_tile_shift; }
+
+  /** Returns the row-major tile buffer, get_width() * get_height() bytes */
+  const char* get_data() const { return m_tiles; }
+
+  /** Returns false for maps created with from_memory() */
+  bool is_writable() const { return !m_owner; }
+
+  /** Changes a tile, only valid if is_writable() */
+  void set(int tx, int ty, char tile)
+  {
+    m_storage[static_cast<size_t>(ty) * static_cast<size_t>(m_width) + static_cast<size_t>(tx)] = tile;
+  }
+
+  /** Returns the tile at tile coordinates \a tx, \a ty */
+  char at(int tx, int ty) const
+  {
+    if ((static_cast<unsigned int>(tx) >= static_cast<unsigned int>(m_width)) |
+        (static_cast<unsigned int>(ty) >= static_cast<unsigned int>(m_height)))
+      return 'X';
+    else
+      return m_tiles[static_cast<size_t>(ty) * static_cast<size_t>(m_width) + static_cast<size_t>(tx)];
+  }
+
+  /** Returns the tile at integer pixel position \a px, \a py */
+  char get_tile_px(int px, int py) const
+  {
+    if ((static_cast<unsigned int>(px) >= m_width_px) |
+        (static_cast<unsigned int>(py) >= m_height_px))
+      return 'X';
+    else
+      return m_tiles[static_cast<size_t>(py >> m_tile_shift) * static_cast<size_t>(m_width) +
+                     static_cast<size_t>(px >> m_tile_shift)];
+  }
+
+  /** Returns the tile at pixel position \a x, \a y */
+  char get_tile(float x, float y) const
+  {
+    // int() truncates towards zero and is undefined out of range, so
+    // negative, too large and NaN positions are rejected while still float
+    if (!(x >= 0.0f && x < static_cast<float>(m_width_px) &&
+          y >= 0.0f && y < static_cast<float>(m_height_px)))
+      return 'X';
+    else
+      return get_tile_px(static_cast<int>(x), static_cast<int>(y));
+  }
+
+  /** Returns true if the tile at pixel position \a x, \a y is solid */
+  bool is_solid(float x, float y) const
+  {
+    return get_tile(x, y) != ' ';
+  }
+};
+
+#endif
+
+/* EOF */
@@ -0,0 +1,151 @@
+#include "world.hpp"
+
+#include "job_system.hpp"
+#include "physics.hpp"
+#include "solid_map.hpp"
+#include "tilemap.hpp"
+
+World::World() :
+  m_x(),
+  m_y(),
+  m_vel_x(),
+  m_vel_y(),
+  m_flags()
+{
+}
+
+size_t
+World::add_body(const Body& body)
+{
+  m_x.push_back(body.x);
+  m_y.push_back(body.y);
+  m_vel_x.push_back(body.vel_x);
+  m_vel_y.push_back(body.vel_y);
+  m_flags.push_back(to_flags(body));
+  return m_x.size() - 1;
+}
+
+void
+World::clear()
+{
+  m_x.clear();
+  m_y.clear();
+  m_vel_x.clear();
+  m_vel_y.clear();
+  m_flags.clear();
+}
+
+void
+World::reserve(size_t count)
+{
+  m_x.reserve(count);
+  m_y.reserve(count);
+  m_vel_x.reserve(count);
+  m_vel_y.reserve(count);
+  m_flags.reserve(count);
+}
+
+Body
+World::get_body(size_t i) const
+{
+  Body body;
+  body.x = m_x[i];
+  body.y = m_y[i];
+  body.vel_x = m_vel_x[i];
+  body.vel_y = m_vel_y[i];
+  from_flags(m_flags[i], body);
+  return body;
+}
+
+void
+World::set_body(size_t i, const Body& body)
+{
+  m_x[i] = body.x;
+  m_y[i] = body.y;
+  m_vel_x[i] = body.vel_x;
+  m_vel_y[i] = body.vel_y;
+  m_flags[i] = to_flags(body);
+}
+
+uint8_t
+World::to_flags(const Body& body)
+{
+  uint8_t flags = 0;
+  if (body.jump)
+    flags |= FLAG_JUMP;
+  if (body.duck)
+    flags |= FLAG_DUCK;
+  if (body.direction == Body::LEFT)
+    flags |= FLAG_LEFT;
+  else if (body.direction == Body::RIGHT)
+    flags |= FLAG_RIGHT;
+  return flags;
+}
+
+void
+World::from_flags(uint8_t flags, Body& body)
+{
+  body.jump = (flags & FLAG_JUMP) != 0;
+  body.duck = (flags & FLAG_DUCK) != 0;
+  if (flags & FLAG_LEFT)
+    body.direction = Body::LEFT;
+  else if (flags & FLAG_RIGHT)
+    body.direction = Body::RIGHT;
+  else
+    body.direction = Body::NONE;
+}
+
+template<typename Map>
+void
+World::step(const Map& map, float delta)
+{
+  step_range(map, delta, 0, size());
+}
+
+template<typename Map>
+void
+World::step(const Map& map, float delta, JobSystem& jobs, size_t chunk_size)
+{
+  jobs.parallel_for(size(), chunk_size,
+                    [this, &map, delta](size_t begin, size_t end) {
+                      step_range(map, delta, begin, end);
+                    });
+}
+
+template<typename Map>
+void
+World::step_range(const Map& map, float delta, size_t begin, size_t end)
+{
+  float* const xs = m_x.data();
+  float* const ys = m_y.data();
+  float* const vel_xs = m_vel_x.data();
+  float* const vel_ys = m_vel_y.data();
+  const uint8_t* const flags = m_flags.data();
+
+  for(size_t i = begin; i < end; ++i)
+    {
+      // the flags only carry input, so they don't need to be written back
+      Body body;
+      body.x = xs[i];
+      body.y = ys[i];
+      body.vel_x = vel_xs[i];
+      body.vel_y = vel_ys[i];
+      from_flags(flags[i], body);
+
+      body_step_swept(map, body, delta);
+
+      xs[i] = body.x;
+      ys[i] = body.y;
+      vel_xs[i] = body.vel_x;
+      vel_ys[i] = body.vel_y;
+    }
+}
+
+template void World::step<TileMap>(const TileMap&, float);
+template void World::step<SolidMap>(const SolidMap&, float);
+template void World::step<TileMap>(const TileMap&, float, JobSystem&, size_t);
+template void World::step<SolidMap>(const SolidMap&, float, JobSystem&, size_t);
+template void World::step_range<TileMap>(const TileMap&, float, size_t, size_t);
+template void World::step_range<SolidMap>(const SolidMap&, float, size_t, size_t);
+
+/* EOF */
@@ -0,0 +1,76 @@
+#ifndef HEADER_JNRCOL_WORLD_HPP
+#define HEADER_JNRCOL_WORLD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "body.hpp"
+
+class JobSystem;
+
+/** A set of bodies stored as structure-of-arrays, each step runs every
+    body through the same logic as body_step_swept(), walking the arrays
+    front to back. */
+class World
+{
+public:
+  enum Flags : uint8_t
+  {
+    FLAG_JUMP  = 1 << 0,
+    FLAG_DUCK  = 1 << 1,
+    FLAG_LEFT  = 1 << 2,
+    FLAG_RIGHT = 1 << 3
+  };
+
+private:
+  std::vector<float> m_x;
+  std::vector<float> m_y;
+  std::vector<float> m_vel_x;
+  std::vector<float> m_vel_y;
+  std::vector<uint8_t> m_flags;
+
+public:
+  World();
+
+  /** Adds \a body and returns its index */
+  size_t add_body(const Body& body);
+  void clear();
+  void reserve(size_t count);
+
+  size_t size() const { return m_x.size(); }
+
+  Body get_body(size_t i) const;
+  void set_body(size_t i, const Body& body);
+
+  const float* get_x() const { return m_x.data(); }
+  const float* get_y() const { return m_y.data(); }
+  const float* get_vel_x() const { return m_vel_x.data(); }
+  const float* get_vel_y() const { return m_vel_y.data(); }
+  const uint8_t* get_flags() const { return m_flags.data(); }
+
+  /** Sets the input of body \a i, see Flags */
+  void set_flags(size_t i, uint8_t flags) { m_flags[i] = flags; }
+
+  /** Advances all bodies by \a delta seconds */
+  template<typename Map>
+  void step(const Map& map, float delta);
+
+  /** Advances all bodies by \a delta seconds, spread over the threads
+      of \a jobs in chunks of \a chunk_size bodies. The result is the
+      same as that of step() for any number of threads. */
+  template<typename Map>
+  void step(const Map& map, float delta, JobSystem& jobs, size_t chunk_size = 1024);
+
+  /** Advances the bodies \a begin to \a end (exclusive), bodies don't
+      interact, so disjoint ranges can be stepped independently */
+  template<typename Map>
+  void step_range(const Map& map, float delta, size_t begin, size_t end);
+
+  static uint8_t to_flags(const Body& body);
+  static void from_flags(uint8_t flags, Body& body);
+};
+
+#endif
+
+/* EOF */